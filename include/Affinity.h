@@ -0,0 +1,69 @@
+#ifndef BOUNCING_BALLS_AFFINITY_H
+#define BOUNCING_BALLS_AFFINITY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Thread placement for the long-lived threads. Each thread opens a
+// ThreadScope when it starts: it is pinned to the CPUs configured for
+// its role (if any), optionally switched to SCHED_FIFO, and registered so its
+// migrations and context switches can be sampled from any thread.
+//
+// CPU lists use the kernel's cpulist syntax ("0-3,8,10-11") or "nodeN" for
+// every CPU of a NUMA node. Pinning is Linux-only; elsewhere it is a no-op.
+
+namespace sim {
+namespace affinity {
+
+enum class Role { Physics, Render, Worker, COUNT };
+
+const char* roleName(Role role);
+
+struct Placement {
+    std::string physicsCpus;
+    std::string renderCpus;
+    // Workers are spread round-robin, one CPU each
+    std::string workerCpus;
+    // SCHED_FIFO priority for the physics thread; 0 keeps the default policy
+    int physicsPriority{0};
+};
+
+// Must be called before the threads it applies to are started
+void configure(const Placement& placement);
+
+// Parses a cpulist or "nodeN"; throws std::invalid_argument on bad syntax
+std::vector<int> parseCpuList(const std::string& text);
+
+// Applies the configured placement to the calling thread and registers it;
+// leaveThread() takes a final sample and unregisters it
+void enterThread(Role role, size_t index = 0);
+void leaveThread();
+
+class ThreadScope {
+public:
+    explicit ThreadScope(Role role, size_t index = 0) { enterThread(role, index); }
+    ~ThreadScope() { leaveThread(); }
+    ThreadScope(const ThreadScope&) = delete;
+    ThreadScope& operator=(const ThreadScope&) = delete;
+};
+
+// NUMA node of the CPU the calling thread is running on (0 if unknown).
+// Only stable for threads pinned within one node.
+int currentNode();
+
+struct SchedStats {
+    uint64_t migrations{0};
+    uint64_t voluntarySwitches{0};
+    uint64_t involuntarySwitches{0};
+};
+
+// Sums the counters of every thread that ever registered for the role;
+// threads that have left contribute their final values.
+SchedStats sample(Role role);
+
+} // namespace affinity
+} // namespace sim
+
+#endif // BOUNCING_BALLS_AFFINITY_H
@@ -0,0 +1,59 @@
+#ifndef BOUNCING_BALLS_ARENA_H
+#define BOUNCING_BALLS_ARENA_H
+
+#include "Config.h"
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace sim {
+
+// Bump allocator for per-step scratch. allocate() is a pointer increment;
+// reset() releases everything at once. If a step outgrows the current block,
+// extra blocks are chained for the rest of that step and the next reset()
+// replaces them with one block big enough for the whole step, so after the
+// first few steps no allocation reaches malloc. Single-threaded: use one
+// arena per worker.
+class Arena {
+public:
+    explicit Arena(size_t initialBytes = config::Memory::ARENA_BLOCK_BYTES);
+    ~Arena();
+    Arena(Arena&& other) noexcept;
+    Arena& operator=(Arena&& other) noexcept;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Uninitialized storage for count objects
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>,
+                      "Arena never runs destructors");
+        return static_cast<T*>(allocateBytes(count * sizeof(T), alignof(T)));
+    }
+
+    void reset();
+
+    size_t capacity() const { return blockSize; }
+    // Largest number of bytes handed out in one step so far
+    size_t highWater() const { return peak; }
+
+private:
+    struct Spill {
+        void* pointer;
+        size_t bytes;
+    };
+
+    void* allocateBytes(size_t bytes, size_t alignment);
+    void release();
+
+    char* block{nullptr};
+    size_t blockSize{0};
+    size_t offset{0};
+    size_t stepBytes{0};   // including spilled blocks
+    size_t peak{0};
+    std::vector<Spill> spills;
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_ARENA_H
@@ -0,0 +1,82 @@
+#ifndef BOUNCING_BALLS_ASYNC_SCENE_H
+#define BOUNCING_BALLS_ASYNC_SCENE_H
+
+#include "Types.h"
+#include "PhysicsBackend.h"
+#include "SnapshotBuffer.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+// A scene for embedders that steps on demand instead of at a fixed rate.
+// Requests run in order as tasks on a small executor shared by every
+// AsyncScene, one batch per turn, so an idle scene holds no thread and many
+// scenes share a few. Callers get futures and never block unless they wait
+// on one. Steps go through the backend's advance(), so device backends keep
+// a batch on the device and CPU backends use their workers.
+class AsyncScene {
+public:
+    AsyncScene(const std::string& backendName, int numBalls, float screenWidth,
+               float screenHeight, uint32_t seed);
+    // Waits for the batch in flight; futures of requests still queued
+    // report std::future_errc::broken_promise
+    ~AsyncScene();
+
+    AsyncScene(const AsyncScene&) = delete;
+    AsyncScene& operator=(const AsyncScene&) = delete;
+
+    // Queues `steps` steps after everything queued earlier. The future holds
+    // the scene's step count once they are done, or the backend's exception;
+    // after an exception every later request fails the same way.
+    std::future<uint64_t> stepAsync(int steps);
+
+    // Resolves with the first snapshot published after this call. Waiters
+    // registered before the same publication share one copy of the state.
+    std::shared_future<Snapshot> nextSnapshot();
+
+    // Most recent complete state without waiting; single consumer, see
+    // SnapshotBuffer::acquire()
+    const Snapshot& latest() { return snapshots.acquire(); }
+
+    const std::string& backendName() const { return name; }
+
+private:
+    struct Request {
+        int remaining{0};
+        std::promise<uint64_t> done;
+    };
+
+    // One executor turn: runs a batch of the front request, then queues
+    // the scene again behind other scenes if requests remain
+    void runBatch();
+    void publish();
+
+    // Touched only by the executor task, which runs one at a time
+    std::unique_ptr<PhysicsBackend> physics;
+    std::vector<Ball> balls;
+    uint64_t stepCount{0};
+
+    std::string name;
+    SnapshotBuffer snapshots;
+
+    std::mutex mutex;
+    std::deque<Request> requests;            // guarded by mutex
+    std::promise<Snapshot> nextPromise;      // guarded by mutex
+    std::shared_future<Snapshot> nextFuture; // guarded by mutex
+    std::exception_ptr failure;              // written under mutex by the executor task
+    bool snapshotWanted{false};              // guarded by mutex
+    bool stopping{false};                    // guarded by mutex
+    bool scheduled{false};                   // a task is queued or running; guarded by mutex
+    std::condition_variable idle;            // signalled when scheduled clears
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_ASYNC_SCENE_H
@@ -0,0 +1,182 @@
+#ifndef BOUNCING_BALLS_BALL_LAYOUT_H
+#define BOUNCING_BALLS_BALL_LAYOUT_H
+
+#include "Types.h"
+#include "Memory.h"
+#include <cstddef>
+
+// Memory layouts for the hot BallState array of the CPU backend, selected at
+// compile time:
+//
+//   Aos         x y vx vy | x y vx vy | ...          (BallState array)
+//   Soa         x x x ... | y y y ... | vx ... | vy ...
+//   Aosoa<W>    W x's, W y's, W vx's, W vy's | next W balls ...
+//
+// Every store exposes its lanes in fixed-size chunks: CHUNK consecutive
+// balls whose x (and y, vx, vy) values sit STRIDE floats apart. Kernels
+// written against a chunk compile to unit-stride SIMD loops for Soa and
+// Aosoa while Aos keeps whole balls in one 16-byte record.
+
+namespace sim {
+namespace layout {
+
+struct Aos {
+    static constexpr const char* NAME = "aos";
+};
+
+struct Soa {
+    static constexpr const char* NAME = "soa";
+};
+
+template <size_t Width>
+struct Aosoa {
+    static_assert(Width && (Width & (Width - 1)) == 0, "Block width must be a power of two");
+    static constexpr size_t WIDTH = Width;
+    static constexpr const char* NAME = Width == 8 ? "aosoa8" : Width == 16 ? "aosoa16" : "aosoa";
+};
+
+} // namespace layout
+
+template <typename Layout>
+class BallStore;
+
+// Pointers to the first ball of a chunk; lane k is at [k * STRIDE]
+template <typename Float>
+struct BallLanes {
+    Float* x;
+    Float* y;
+    Float* vx;
+    Float* vy;
+};
+
+template <>
+class BallStore<layout::Aos> {
+public:
+    static constexpr size_t CHUNK = 16;
+    static constexpr size_t STRIDE = sizeof(BallState) / sizeof(float);
+
+    void resize(size_t count) { states.resize(count); }
+    void reserve(size_t count) { states.reserve(count); }
+    void clear() { states.clear(); }
+    size_t size() const { return states.size(); }
+    void push_back(const BallState& state) { states.push_back(state); }
+
+    BallState load(size_t i) const { return states[i]; }
+    void store(size_t i, const BallState& state) { states[i] = state; }
+
+    BallLanes<float> lanes(size_t first) {
+        BallState* s = &states[first];
+        return {&s->position.x, &s->position.y, &s->velocity.x, &s->velocity.y};
+    }
+    BallLanes<const float> lanes(size_t first) const {
+        const BallState* s = &states[first];
+        return {&s->position.x, &s->position.y, &s->velocity.x, &s->velocity.y};
+    }
+
+private:
+    memory::LargeVector<BallState> states;
+};
+
+template <>
+class BallStore<layout::Soa> {
+public:
+    static constexpr size_t CHUNK = 16;
+    static constexpr size_t STRIDE = 1;
+
+    void resize(size_t count) {
+        x.resize(count);
+        y.resize(count);
+        vx.resize(count);
+        vy.resize(count);
+    }
+    void reserve(size_t count) {
+        x.reserve(count);
+        y.reserve(count);
+        vx.reserve(count);
+        vy.reserve(count);
+    }
+    void clear() { resize(0); }
+    size_t size() const { return x.size(); }
+    void push_back(const BallState& state) {
+        x.push_back(state.position.x);
+        y.push_back(state.position.y);
+        vx.push_back(state.velocity.x);
+        vy.push_back(state.velocity.y);
+    }
+
+    BallState load(size_t i) const { return {Vec2(x[i], y[i]), Vec2(vx[i], vy[i])}; }
+    void store(size_t i, const BallState& state) {
+        x[i] = state.position.x;
+        y[i] = state.position.y;
+        vx[i] = state.velocity.x;
+        vy[i] = state.velocity.y;
+    }
+
+    BallLanes<float> lanes(size_t first) { return {&x[first], &y[first], &vx[first], &vy[first]}; }
+    BallLanes<const float> lanes(size_t first) const {
+        return {&x[first], &y[first], &vx[first], &vy[first]};
+    }
+
+private:
+    memory::LargeVector<float> x;
+    memory::LargeVector<float> y;
+    memory::LargeVector<float> vx;
+    memory::LargeVector<float> vy;
+};
+
+template <size_t Width>
+class BallStore<layout::Aosoa<Width>> {
+public:
+    static constexpr size_t CHUNK = Width;
+    static constexpr size_t STRIDE = 1;
+
+    void resize(size_t count_) {
+        blocks.resize((count_ + Width - 1) / Width);
+        count = count_;
+    }
+    void reserve(size_t count_) { blocks.reserve((count_ + Width - 1) / Width); }
+    void clear() { resize(0); }
+    size_t size() const { return count; }
+    void push_back(const BallState& state) {
+        if (count % Width == 0) blocks.emplace_back();
+        store(count++, state);
+    }
+
+    BallState load(size_t i) const {
+        const Block& b = blocks[i / Width];
+        const size_t lane = i % Width;
+        return {Vec2(b.x[lane], b.y[lane]), Vec2(b.vx[lane], b.vy[lane])};
+    }
+    void store(size_t i, const BallState& state) {
+        Block& b = blocks[i / Width];
+        const size_t lane = i % Width;
+        b.x[lane] = state.position.x;
+        b.y[lane] = state.position.y;
+        b.vx[lane] = state.velocity.x;
+        b.vy[lane] = state.velocity.y;
+    }
+
+    BallLanes<float> lanes(size_t first) {
+        Block& b = blocks[first / Width];
+        return {b.x, b.y, b.vx, b.vy};
+    }
+    BallLanes<const float> lanes(size_t first) const {
+        const Block& b = blocks[first / Width];
+        return {b.x, b.y, b.vx, b.vy};
+    }
+
+private:
+    struct alignas(64) Block {
+        float x[Width];
+        float y[Width];
+        float vx[Width];
+        float vy[Width];
+    };
+
+    memory::LargeVector<Block> blocks;
+    size_t count{0};
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_BALL_LAYOUT_H
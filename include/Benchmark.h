@@ -0,0 +1,57 @@
+#ifndef BOUNCING_BALLS_BENCHMARK_H
+#define BOUNCING_BALLS_BENCHMARK_H
+
+#include "Config.h"
+#include "PhysicsBackend.h"
+#include <string>
+#include <vector>
+
+namespace sim {
+
+struct BenchmarkOptions {
+    std::string backendName{backend::CPU};
+    int numBalls{config::Benchmark::DEFAULT_BALLS};
+    int steps{config::Benchmark::DEFAULT_STEPS};
+    int warmupSteps{config::Benchmark::WARMUP_STEPS};
+    // Steps per advance() call; 1 steps with updatePhysics()
+    int batchSteps{1};
+    uint32_t seed{config::Validation::DEFAULT_SEED};
+    // Attribute hardware counters to phases (Linux perf_event_open)
+    bool perfCounters{false};
+    // Grid prefetch distances to rerun the backend with; empty skips the sweep
+    std::vector<size_t> prefetchSweep;
+    // Empty writes the JSON report to stdout
+    std::string outputPath;
+};
+
+// Headless fixed-step run of one backend; writes a JSON report with
+// per-phase latency percentiles and, optionally, hardware counters and a
+// sweep over the CPU narrowphase prefetch distance.
+class Benchmark {
+public:
+    explicit Benchmark(BenchmarkOptions options);
+
+    // Returns false if the report could not be written
+    bool run();
+
+private:
+    BenchmarkOptions options;
+};
+
+// Single-threaded microbenchmark of the CPU kernels over every hot-state
+// layout (AoS, SoA, AoSoA-8, AoSoA-16) on the same scene. Uses numBalls,
+// steps (iterations), seed, perfCounters and outputPath; the backend name
+// is ignored.
+class LayoutBenchmark {
+public:
+    explicit LayoutBenchmark(BenchmarkOptions options);
+
+    bool run();
+
+private:
+    BenchmarkOptions options;
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_BENCHMARK_H
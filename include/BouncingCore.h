@@ -0,0 +1,71 @@
+#ifndef BOUNCING_BALLS_BOUNCING_CORE_H
+#define BOUNCING_BALLS_BOUNCING_CORE_H
+
+/*
+ * C API of the bouncing_core library: headless scenes on any physics
+ * backend, for host applications and language bindings. A scene is not
+ * thread-safe; call into one scene from one thread at a time.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped on any incompatible change to the declarations below */
+#define BB_API_VERSION 1
+
+typedef struct bb_scene bb_scene;
+
+typedef enum bb_status {
+    BB_OK = 0,
+    BB_INVALID_ARGUMENT = 1,
+    BB_BACKEND_ERROR = 2  /* the scene is unusable until bb_scene_destroy */
+} bb_status;
+
+/*
+ * Borrowed view of the live ball state; nothing is copied. Ball i of a
+ * field is at (const char*)field + i * stride. The pointers stay valid
+ * until the next bb_scene_step, bb_scene_spawn or bb_scene_destroy on the
+ * scene.
+ */
+typedef struct bb_state_view {
+    size_t count;
+    size_t stride;  /* bytes between consecutive balls, same for every field */
+    uint64_t step;  /* steps completed */
+    const float* position_x;
+    const float* position_y;
+    const float* velocity_x;
+    const float* velocity_y;
+    const float* radius;
+    const float* mass;
+    const uint32_t* color;  /* RGBA */
+} bb_state_view;
+
+int bb_api_version(void);
+
+/*
+ * backend takes the --backend names (NULL for "cpu"). The same seed always
+ * produces the same scene. Returns NULL on failure; see bb_last_error.
+ */
+bb_scene* bb_scene_create(const char* backend, int balls, float width, float height,
+                          uint32_t seed);
+void bb_scene_destroy(bb_scene* scene);
+
+/* Advances the scene; batches of more than one step may stay on the device */
+bb_status bb_scene_step(bb_scene* scene, int steps);
+/* Adds count random balls and reloads the backend */
+bb_status bb_scene_spawn(bb_scene* scene, int count, uint32_t seed);
+bb_status bb_scene_view(const bb_scene* scene, bb_state_view* view);
+
+const char* bb_scene_backend(const bb_scene* scene);
+/* Message of the last failed call on this thread, "" if none */
+const char* bb_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BOUNCING_BALLS_BOUNCING_CORE_H */
@@ -0,0 +1,207 @@
+#ifndef BOUNCING_BALLS_CPU_KERNELS_H
+#define BOUNCING_BALLS_CPU_KERNELS_H
+
+#include "BallLayout.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Host versions of updateBallPhysics and detectCollisions, written against
+// the chunked lanes of a BallStore so every layout runs the same arithmetic
+// in the same order. Shared by CPUPhysics and the layout microbenchmarks.
+
+namespace sim {
+namespace kernels {
+
+// Integration and boundary response for `count` lanes starting at a chunk
+template <size_t Stride>
+inline void integrateLanes(const BallLanes<float>& ball, const BallProperties* properties,
+                           size_t count, const SimConstants& constants) {
+    const float dt = constants.dt;
+    const float gravity = constants.gravity;
+    const float width = constants.screenDimensions.x;
+    const float height = constants.screenDimensions.y;
+    const float restitution = constants.restitution;
+
+    for (size_t k = 0; k < count; ++k) {
+        float& x = ball.x[k * Stride];
+        float& y = ball.y[k * Stride];
+        float& vx = ball.vx[k * Stride];
+        float& vy = ball.vy[k * Stride];
+        const float radius = properties[k].radius;
+
+        vy += gravity * dt;
+        x += vx * dt;
+        y += vy * dt;
+
+        // Horizontal boundaries
+        if (x - radius < 0.0f) {
+            x = radius;
+            vx = std::fabs(vx) * restitution;
+        }
+        else if (x + radius > width) {
+            x = width - radius;
+            vx = -std::fabs(vx) * restitution;
+        }
+
+        // Vertical boundaries
+        if (y - radius < 0.0f) {
+            y = radius;
+            vy = std::fabs(vy) * restitution;
+        }
+        else if (y + radius > height) {
+            y = height - radius;
+            vy = -std::fabs(vy) * restitution;
+        }
+    }
+}
+
+// Impulse on `ball` from one touching neighbour, as in detectCollisions
+inline void applyContact(BallState& ball, const BallProperties& properties,
+                         const BallState& other, float otherInverseMass, float restitution) {
+    const float dx = other.position.x - ball.position.x;
+    const float dy = other.position.y - ball.position.y;
+    const float dist = std::sqrt(dx * dx + dy * dy);
+    const float nx = dx / dist;
+    const float ny = dy / dist;
+
+    const float rvx = other.velocity.x - ball.velocity.x;
+    const float rvy = other.velocity.y - ball.velocity.y;
+    const float velAlongNormal = rvx * nx + rvy * ny;
+
+    // Only resolve if balls are moving toward each other
+    if (velAlongNormal < 0) {
+        float impulse = -(1.0f + restitution) * velAlongNormal;
+        impulse /= properties.inverseMass + otherInverseMass;
+
+        ball.velocity.x -= impulse * nx * properties.inverseMass;
+        ball.velocity.y -= impulse * ny * properties.inverseMass;
+    }
+}
+
+// Ball-ball response of one ball against an integrated snapshot. Each chunk
+// is first tested for overlap in a branch-free loop; the few hits are then
+// resolved in index order. Returns the touching pairs this ball heads.
+template <typename Store>
+inline uint32_t resolveCollisions(BallState& ball, const BallProperties& properties, size_t index,
+                                  const Store& snapshot, const float* radii,
+                                  const BallProperties* snapshotProperties, size_t count,
+                                  float restitution) {
+    constexpr size_t CHUNK = Store::CHUNK;
+    constexpr size_t STRIDE = Store::STRIDE;
+    uint32_t contacts = 0;
+
+    for (size_t first = 0; first < count; first += CHUNK) {
+        const size_t lanes = std::min(CHUNK, count - first);
+        const BallLanes<const float> other = snapshot.lanes(first);
+
+        uint8_t touching[CHUNK];
+        uint8_t any = 0;
+        for (size_t k = 0; k < lanes; ++k) {
+            const float dx = other.x[k * STRIDE] - ball.position.x;
+            const float dy = other.y[k * STRIDE] - ball.position.y;
+            const float distSq = dx * dx + dy * dy;
+            const float minDist = properties.radius + radii[first + k];
+            touching[k] = (distSq < minDist * minDist) & (distSq > 0.0f);
+            any |= touching[k];
+        }
+        if (!any) continue;
+
+        for (size_t k = 0; k < lanes; ++k) {
+            const size_t j = first + k;
+            if (!touching[k] || j == index) continue;
+
+            // Each touching pair is counted once, by its lower index
+            if (index < j) ++contacts;
+
+            applyContact(ball, properties, snapshot.load(j), snapshotProperties[j].inverseMass,
+                         restitution);
+        }
+    }
+
+    return contacts;
+}
+
+// Neighbour found by the grid: ball id and its slot in the cell-sorted snapshot
+struct Hit {
+    uint32_t id;
+    uint32_t slot;
+};
+
+// Appends every ball in slots [begin, end) of a cell-sorted snapshot that
+// overlaps `ball`. Uses the same chunked overlap test as resolveCollisions.
+template <typename Store>
+inline void collectHits(const BallState& ball, float radius, const Store& snapshot,
+                        const float* radii, const uint32_t* ids, size_t begin, size_t end,
+                        std::vector<Hit>& hits) {
+    constexpr size_t CHUNK = Store::CHUNK;
+    constexpr size_t STRIDE = Store::STRIDE;
+
+    for (size_t first = begin - begin % CHUNK; first < end; first += CHUNK) {
+        const size_t from = std::max(first, begin) - first;
+        const size_t to = std::min(first + CHUNK, end) - first;
+        const BallLanes<const float> other = snapshot.lanes(first);
+
+        uint8_t touching[CHUNK];
+        uint8_t any = 0;
+        for (size_t k = from; k < to; ++k) {
+            const float dx = other.x[k * STRIDE] - ball.position.x;
+            const float dy = other.y[k * STRIDE] - ball.position.y;
+            const float distSq = dx * dx + dy * dy;
+            const float minDist = radius + radii[first + k];
+            touching[k] = (distSq < minDist * minDist) & (distSq > 0.0f);
+            any |= touching[k];
+        }
+        if (!any) continue;
+
+        for (size_t k = from; k < to; ++k) {
+            if (touching[k]) {
+                hits.push_back({ids[first + k], static_cast<uint32_t>(first + k)});
+            }
+        }
+    }
+}
+
+// Resolves hits already sorted by id, so the impulses are summed in the
+// same order as the all-pairs loop and results match it bitwise
+template <typename Store>
+inline uint32_t resolveHits(BallState& ball, const BallProperties& properties, size_t index,
+                            const Store& snapshot, const BallProperties* snapshotProperties,
+                            const Hit* hits, size_t count, float restitution) {
+    uint32_t contacts = 0;
+    for (size_t h = 0; h < count; ++h) {
+        const Hit& hit = hits[h];
+        if (hit.id == index) continue;
+        if (index < hit.id) ++contacts;
+        applyContact(ball, properties, snapshot.load(hit.slot),
+                     snapshotProperties[hit.slot].inverseMass, restitution);
+    }
+    return contacts;
+}
+
+// Pulls the start of slots [begin, end) into cache ahead of collectHits()
+template <typename Store>
+inline void prefetchSlots(const Store& snapshot, const float* radii, size_t begin, size_t end) {
+#if defined(__GNUC__)
+    constexpr size_t MAX_CHUNKS = 4;
+    size_t chunks = 0;
+    for (size_t first = begin - begin % Store::CHUNK; first < end && chunks < MAX_CHUNKS;
+         first += Store::CHUNK, ++chunks) {
+        const BallLanes<const float> lanes = snapshot.lanes(first);
+        __builtin_prefetch(lanes.x);
+        __builtin_prefetch(lanes.y);
+        __builtin_prefetch(radii + first);
+    }
+#else
+    (void)snapshot;
+    (void)radii;
+    (void)begin;
+    (void)end;
+#endif
+}
+
+} // namespace kernels
+} // namespace sim
+
+#endif // BOUNCING_BALLS_CPU_KERNELS_H
@@ -0,0 +1,142 @@
+#ifndef BOUNCING_BALLS_CPU_PHYSICS_H
+#define BOUNCING_BALLS_CPU_PHYSICS_H
+
+#include "PhysicsBackend.h"
+#include "WorkerPool.h"
+#include "Arena.h"
+#include "Memory.h"
+#include "BallLayout.h"
+#include "CPUKernels.h"
+#include <memory>
+
+namespace sim {
+
+namespace grid {
+
+// Process-wide distance, in balls, at which the CPU narrowphase prefetches
+// neighbour cells ahead of use; 0 disables prefetching. Read every step.
+void setPrefetchDistance(size_t distance);
+size_t prefetchDistance();
+
+} // namespace grid
+
+// Host implementation of the kernels in simulation.cl. Collision response
+// reads from a copy of the integrated state, so results do not depend on
+// the number of workers or on scheduling order.
+//
+// Balls live in one spatial partition per worker (vertical strips of the
+// screen). Each partition's storage is first-touched by the worker that owns
+// it, and strips are handed out so that workers on the same NUMA node own
+// adjacent strips; balls crossing a strip boundary migrate between
+// partitions at the end of the step. The collision snapshot is replicated
+// once per node so the neighbour reads stay node-local.
+//
+// Each step bins the integrated balls into a uniform grid whose cells are as
+// wide as the largest touching distance, and the snapshot is written in cell
+// order. Every partition then walks its balls cell by cell, testing only the
+// 3x3 neighbouring cells while prefetching the cells of the ball
+// grid::prefetchDistance() positions ahead. Hits are resolved in ball-id
+// order, so results match the all-pairs kernel bitwise.
+//
+// Balls are stored split: the hot BallState array in the memory layout given
+// by the template parameter (see BallLayout.h) and a cold BallProperties
+// record only read for radii and contacts. All layouts produce bitwise
+// identical results.
+template <typename Layout>
+class BasicCPUPhysics : public PhysicsBackend {
+public:
+    // numThreads == 0 uses std::thread::hardware_concurrency()
+    explicit BasicCPUPhysics(size_t numThreads = 0);
+    ~BasicCPUPhysics() override;
+
+    void initialize(size_t numBalls, int screenWidth, int screenHeight) override;
+    void cleanup() override;
+    void updatePhysics(std::vector<Ball>& balls) override;
+    void setConstants(const SimConstants& consts) override { constants = consts; }
+    std::string name() const override;
+    StepStats lastStepStats() const override { return stepStats; }
+
+private:
+    struct Partition {
+        BallStore<Layout> states;
+        memory::LargeVector<BallProperties> properties;
+        memory::LargeVector<uint32_t> ids;  // index in the caller's vector
+        // Per-step scratch owned by this partition's worker
+        Arena scratch;
+        // Balls leaving this strip, carved from scratch during the step
+        BallState* outStates{nullptr};
+        BallProperties* outProperties{nullptr};
+        uint32_t* outIds{nullptr};
+        uint32_t* outTargets{nullptr};      // destination partition
+        size_t outCount{0};
+        size_t strip{0};
+        size_t replica{0};                  // snapshot copy on this worker's node
+        std::vector<kernels::Hit> hits;     // neighbours of the current ball
+    };
+
+    // Integrated state of every ball in grid cell order
+    struct Snapshot {
+        BallStore<Layout> states;
+        memory::LargeVector<float> radii;
+        memory::LargeVector<BallProperties> properties;
+        memory::LargeVector<uint32_t> ids;  // slot -> ball id
+    };
+
+    // Row-major cells over the screen, rebuilt every step
+    struct Grid {
+        size_t columns{1};
+        size_t rows{1};
+        float cellSize{1.0f};
+        memory::LargeVector<uint32_t> cellOf;     // ball id -> cell
+        memory::LargeVector<uint32_t> cellStart;  // cell -> first slot, plus an end entry
+        memory::LargeVector<uint32_t> order;      // slot -> ball id
+    };
+
+    void assignStrips();
+    size_t partitionAt(float x) const;
+    uint32_t cellAt(const Vec2& position) const;
+    void scatter(const std::vector<Ball>& balls, size_t partition);
+    void sortCells();
+    void migrateIn(size_t partition);
+
+    // Per-worker accumulators, padded to avoid false sharing
+    struct alignas(64) WorkerCounters {
+        uint32_t contacts{0};
+        uint32_t migrations{0};
+    };
+
+    std::unique_ptr<WorkerPool> workers;
+    size_t requestedThreads;
+
+    // One partition per worker; partition i is always processed by worker i
+    std::vector<Partition> partitions;
+    std::vector<size_t> stripOwner;      // strip -> partition
+    float stripWidth{0.0f};
+    bool scattered{false};
+
+    // Integrated state and constant properties, by ball id
+    memory::LargeVector<BallState> current;
+    memory::LargeVector<BallProperties> properties;
+    Grid grid;
+
+    // Read by the collision pass; one copy per NUMA node in use
+    std::vector<Snapshot> snapshots;
+    std::vector<WorkerCounters> workerCounters;
+
+    bool initialized{false};
+    size_t numBalls{0};
+    SimConstants constants;
+    StepStats stepStats;
+};
+
+// Explicitly instantiated in CPUPhysics.cpp
+extern template class BasicCPUPhysics<layout::Aos>;
+extern template class BasicCPUPhysics<layout::Soa>;
+extern template class BasicCPUPhysics<layout::Aosoa<8>>;
+extern template class BasicCPUPhysics<layout::Aosoa<16>>;
+
+using CPUPhysics = BasicCPUPhysics<layout::Aos>;
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_CPU_PHYSICS_H
@@ -23,6 +23,9 @@ struct Physics {
     static constexpr float DT = 1.0f / RATE;
     static constexpr float GRAVITY = 9.81f;
     static constexpr float RESTITUTION = 0.8f;
+    static constexpr float GRAVITY_STEP = 5.0f;  // per Up/Down key press
+    // Takes over when a step throws; also the B-key alternative to OpenCL
+    static constexpr const char* FAILOVER_BACKEND = "cpu";
 };
 
 // Ball configuration
@@ -30,6 +33,7 @@ struct Balls {
     static constexpr int MIN_COUNT = 3;
     static constexpr int MAX_COUNT = 200;
     static constexpr int DEFAULT_COUNT = 50;
+    static constexpr int SPAWN_COUNT = 10;       // per Space key press
     static constexpr float MIN_RADIUS = 15.0f;
     static constexpr float MAX_RADIUS = 25.0f;
     static constexpr float VELOCITY_RANGE = 100.0f;
@@ -49,6 +53,129 @@ struct Balls {
 struct OpenCL {
     static constexpr size_t WORKGROUP_SIZE = 256;
     static constexpr const char* KERNEL_FILENAME = "simulation.cl";
+    static constexpr const char* BUILD_OPTIONS = "-cl-std=CL1.2";
+    // Falls back to an in-order queue where the device does not support it
+    static constexpr bool OUT_OF_ORDER_QUEUE = true;
+    // Record the step plan with cl_khr_command_buffer where available
+    static constexpr bool COMMAND_BUFFERS = true;
+    // opencl-persistent: one work-group loops over a batch of steps. Larger
+    // scenes outgrow a single compute unit and use per-step launches.
+    static constexpr size_t PERSISTENT_MAX_BALLS = 4096;
+    static constexpr int PERSISTENT_POLL_MICROSECONDS = 50;
+    // Appended for the opencl-fast backend; SIM_FAST_MATH selects the
+    // native_rsqrt / native_divide paths in simulation.cl
+    static constexpr const char* FAST_MATH_OPTIONS =
+        " -cl-fast-relaxed-math -cl-mad-enable -DSIM_FAST_MATH";
+};
+
+// Uniform-grid broadphase of the CPU backends
+struct Grid {
+    // Balls whose neighbour cells are prefetched ahead of the narrowphase;
+    // 0 disables prefetching
+    static constexpr size_t PREFETCH_DISTANCE = 8;
+    static constexpr size_t PREFETCH_SWEEP[] = {0, 2, 4, 8, 16, 32};
+};
+
+// Cross-backend differential testing
+struct Validation {
+    static constexpr int DEFAULT_STEPS = 600;
+    static constexpr uint32_t DEFAULT_SEED = 42;
+    // Max per-ball position error in pixels allowed against a backend
+    static constexpr float CPU_POSITION_TOLERANCE = 0.0f;
+    static constexpr float OPENCL_POSITION_TOLERANCE = 0.5f;
+    static constexpr float OPENCL_FAST_POSITION_TOLERANCE = 2.0f;
+    // Max energy difference relative to the reference energy
+    static constexpr double CPU_ENERGY_TOLERANCE = 0.0;
+    static constexpr double OPENCL_ENERGY_TOLERANCE = 1e-3;
+    static constexpr double OPENCL_FAST_ENERGY_TOLERANCE = 1e-2;
+};
+
+// Headless benchmark runs
+struct Benchmark {
+    static constexpr int DEFAULT_BALLS = 2000;
+    static constexpr int DEFAULT_STEPS = 1000;
+    static constexpr int LAYOUT_ITERATIONS = 50;  // all-pairs is O(n^2) per iteration
+    static constexpr int WARMUP_STEPS = 50;
+};
+
+// Latency histogram reporting
+struct Stats {
+    static constexpr double REPORT_INTERVAL_SECONDS = 10.0;
+    static constexpr double SCHED_SAMPLE_INTERVAL_SECONDS = 1.0;
+};
+
+// Prometheus metrics endpoint
+struct Metrics {
+    static constexpr const char* PREFIX = "bouncing_balls_";
+    static constexpr const char* DEFAULT_ENDPOINT = "unix:/tmp/bouncing_balls.metrics.sock";
+    static constexpr double HISTOGRAM_BOUNDS_SECONDS[] = {
+        0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.0167, 0.025, 0.05, 0.1, 0.25, 1.0
+    };
+    static constexpr int POLL_INTERVAL_MS = 200;
+};
+
+// Multi-session scene server (--serve)
+struct Server {
+    static constexpr const char* DEFAULT_SOCKET = "/tmp/bouncing_balls.sock";
+    static constexpr const char* DEFAULT_BACKEND = "cpu-serial";
+    static constexpr int QUANTUM_STEPS = 16;          // per session per round
+    static constexpr size_t MAX_SESSIONS = 256;
+    static constexpr uint32_t MAX_SESSION_BALLS = 100000;
+    static constexpr uint32_t MAX_REQUEST_BYTES = 4096;
+    // Replies queued for a client; past this its requests wait until it reads
+    static constexpr size_t MAX_CLIENT_OUTPUT_BYTES = 8u << 20;
+    // Requests buffered while replies are held back; past this the client is dropped
+    static constexpr size_t MAX_CLIENT_INPUT_BYTES = 64u << 10;
+    static constexpr int POLL_INTERVAL_MS = 200;
+};
+
+// Snapshot streaming to remote viewers (--stream / --view)
+struct Stream {
+    static constexpr const char* DEFAULT_SOCKET = "/tmp/bouncing_balls.stream.sock";
+    static constexpr float POSITION_QUANTUM = 0.125f;  // px per position unit on the wire
+    static constexpr int KEYFRAME_INTERVAL = 120;      // frames per viewer between keyframes
+    static constexpr double DEFAULT_FPS = 30.0;
+    static constexpr double MAX_FPS = 240.0;
+    static constexpr int PUBLISH_EVERY_STEPS = 4;      // headless runs publish at 60 Hz
+    static constexpr int POLL_INTERVAL_MS = 200;
+};
+
+// Multi-process runs (--distributed)
+struct Distributed {
+    // Ghost zone either side of a slab edge: the longest contact distance,
+    // which is also the local grid's cell size
+    static constexpr float HALO = 2.0f * Balls::MAX_RADIUS;
+    static constexpr int MAX_RANKS = 64;
+};
+
+// Asynchronous logger
+struct Log {
+    static constexpr size_t LINE_CAPACITY = 256;   // longer lines are truncated
+    static constexpr size_t RING_SLOTS = 512;      // per logging thread
+    static constexpr int FLUSH_INTERVAL_MS = 20;
+};
+
+// Timeline tracing (only used when built with SIM_ENABLE_TRACING)
+struct Trace {
+    static constexpr size_t EVENTS_PER_THREAD = 1 << 18;
+    static constexpr const char* DEFAULT_FILENAME = "trace.json";
+};
+
+// Physics buffer allocation
+struct Memory {
+    static constexpr size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+    // Allocations at least this large are mmap'd and may use huge pages
+    static constexpr size_t LARGE_ALLOCATION_BYTES = HUGE_PAGE_BYTES;
+    static constexpr size_t ARENA_BLOCK_BYTES = size_t(256) << 10;
+};
+
+// Embedded scenes stepped through AsyncScene
+struct Async {
+    // stepAsync splits longer requests so snapshot waiters see progress
+    static constexpr int MAX_BATCH_STEPS = 64;
+    // Threads shared by every AsyncScene; a device batch holds one while
+    // it waits on the device
+    static constexpr size_t EXECUTOR_THREADS = 4;
 };
 
 // Error messages
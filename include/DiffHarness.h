@@ -0,0 +1,81 @@
+#ifndef BOUNCING_BALLS_DIFF_HARNESS_H
+#define BOUNCING_BALLS_DIFF_HARNESS_H
+
+#include "Types.h"
+#include "Config.h"
+#include "PhysicsBackend.h"
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+namespace sim {
+
+struct DiffOptions {
+    std::string referenceBackend{backend::CPU_SERIAL};
+    std::string candidateBackend{backend::OPENCL};
+    int numBalls{config::Balls::DEFAULT_COUNT};
+    int steps{config::Validation::DEFAULT_STEPS};
+    uint32_t seed{config::Validation::DEFAULT_SEED};
+    float screenWidth{static_cast<float>(config::Display::DEFAULT_WIDTH)};
+    float screenHeight{static_cast<float>(config::Display::DEFAULT_HEIGHT)};
+    // Require bit-identical state after every step
+    bool deterministic{false};
+};
+
+struct Tolerance {
+    float position{0.0f};
+    double relativeEnergy{0.0};
+};
+
+struct StepDivergence {
+    int step{0};
+    float maxPositionError{0.0f};
+    float maxVelocityError{0.0f};
+    double referenceEnergy{0.0};
+    double candidateEnergy{0.0};
+    double energyDifference{0.0};
+    bool bitwiseEqual{false};
+};
+
+struct DiffReport {
+    std::string referenceBackend;
+    std::string candidateBackend;
+    Tolerance tolerance;
+    bool deterministic{false};
+    std::vector<StepDivergence> steps;
+    int firstFailingStep{-1};
+
+    // Worst divergence over the whole run, e.g. the cost of fast math
+    float maxPositionError{0.0f};
+    float maxVelocityError{0.0f};
+    double maxRelativeEnergyError{0.0};
+
+    bool passed() const { return firstFailingStep < 0; }
+    void print(std::ostream& out) const;
+};
+
+// Tolerance to apply when comparing against the named backend
+Tolerance toleranceFor(const std::string& backendName);
+
+// How far `candidate` is from `reference` (same balls, same order); `step`
+// is left at 0 for the caller to fill in
+StepDivergence compareStates(const std::vector<Ball>& reference,
+                             const std::vector<Ball>& candidate, const SimConstants& constants);
+
+// Runs the same seeded scene on two backends in lock step and records how far
+// the candidate drifts from the reference after every step.
+class DifferentialHarness {
+public:
+    explicit DifferentialHarness(DiffOptions options);
+
+    DiffReport run();
+
+private:
+    bool exceedsTolerance(const StepDivergence& divergence, const Tolerance& tolerance) const;
+
+    DiffOptions options;
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_DIFF_HARNESS_H
@@ -0,0 +1,99 @@
+#ifndef BOUNCING_BALLS_DISTRIBUTED_H
+#define BOUNCING_BALLS_DISTRIBUTED_H
+
+#include "Types.h"
+#include "Config.h"
+#include "Transport.h"
+#include "CPUKernels.h"
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+struct DistributedOptions {
+    int ranks{2};
+    int numBalls{config::Balls::DEFAULT_COUNT};
+    int steps{config::Validation::DEFAULT_STEPS};
+    uint32_t seed{config::Validation::DEFAULT_SEED};
+    float screenWidth{static_cast<float>(config::Display::DEFAULT_WIDTH)};
+    float screenHeight{static_cast<float>(config::Display::DEFAULT_HEIGHT)};
+    // Rank 0 replays the run on cpu-serial and requires bitwise equality
+    bool verify{true};
+};
+
+// Per-rank totals over a run, gathered on rank 0 for the report
+struct RankStats {
+    uint32_t balls{0};        // owned at the end
+    uint64_t ghosts{0};       // summed over steps
+    uint64_t migrations{0};   // balls received from a neighbour
+    uint64_t contacts{0};
+    uint64_t computeNs{0};    // integrate + narrowphase
+    uint64_t commNs{0};       // pack, exchange (including waiting on neighbours), unpack
+};
+
+// One rank of a distributed run. The world is cut into vertical slabs, one
+// per rank. A step integrates the owned balls, then swaps one message with
+// each neighbour. The message carries the balls that left the slab, which
+// the neighbour now owns, and the balls within the halo of the shared edge
+// as ghosts. Every owned ball is then resolved against owned and ghost
+// balls on a local grid in id order. That matches a single-process step
+// bitwise.
+class SlabRank {
+public:
+    SlabRank(Transport& transport, const DistributedOptions& options);
+
+    // Runs options.steps steps; rank 0 writes the report. Returns false on
+    // rank 0 when balls were lost or duplicated, or differ from cpu-serial.
+    bool run(std::ostream& report);
+
+private:
+    struct Entry {
+        uint32_t id;
+        Ball ball;
+    };
+
+    int ownerOf(float x) const;
+    void integrate();
+    void exchangeHalo();
+    void collide();
+    bool gather(std::ostream& report);
+
+    Transport& transport;
+    DistributedOptions options;
+    SimConstants constants{};
+    float slabWidth{0.0f};
+    float slabLeft{0.0f};
+    float slabRight{0.0f};
+
+    std::vector<Entry> owned;
+    std::vector<Entry> ghosts;  // this step only
+    RankStats stats;
+
+    // Local grid over the slab and its halo, rebuilt every step
+    struct Grid {
+        float originX{0.0f};
+        int columns{0};
+        int rows{0};
+        std::vector<uint32_t> cellStart;
+        std::vector<uint32_t> cellOf;
+    } grid;
+    BallStore<layout::Aos> snapshot;  // cell order
+    std::vector<float> radii;
+    std::vector<BallProperties> properties;
+    std::vector<uint32_t> ids;
+    std::vector<kernels::Hit> hits;
+};
+
+// Spawns ranks 1..ranks-1 as copies of this executable (argv plus the
+// internal --rank/--rank-fds flags) connected by a LocalSocketTransport,
+// runs rank 0 here and waits for the others. Returns the exit status.
+int launchDistributed(const DistributedOptions& options, int argc, char* argv[]);
+
+// Entry point of a spawned rank
+int runRank(const DistributedOptions& options, int rank, const std::string& fdList);
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_DISTRIBUTED_H
@@ -0,0 +1,22 @@
+#ifndef BOUNCING_BALLS_FONT_H
+#define BOUNCING_BALLS_FONT_H
+
+#include <cstdint>
+
+namespace sim {
+namespace font {
+
+// Fixed-width bitmap font covering printable ASCII. Each glyph is
+// GLYPH_HEIGHT rows from top to bottom, one byte per row, MSB = leftmost.
+constexpr int GLYPH_WIDTH = 8;
+constexpr int GLYPH_HEIGHT = 14;
+constexpr char FIRST_CHAR = ' ';
+constexpr char LAST_CHAR = '~';
+constexpr int GLYPH_COUNT = LAST_CHAR - FIRST_CHAR + 1;
+
+extern const uint8_t GLYPHS[GLYPH_COUNT][GLYPH_HEIGHT];
+
+} // namespace font
+} // namespace sim
+
+#endif // BOUNCING_BALLS_FONT_H
@@ -3,21 +3,38 @@
 
 #include "Types.h"
 #include "Config.h"
+#include "PhysicsBackend.h"
+#include "StepPlan.h"
 #include <vector>
 #include <string>
 
 namespace sim {
 
-class GPUManager {
+// Floating-point model the kernels are built with
+enum class KernelMath {
+    Precise,  // IEEE sqrt and division
+    Fast,     // relaxed math and mad contraction, native_rsqrt / native_divide
+};
+
+class GPUManager : public PhysicsBackend {
 public:
-    GPUManager() = default;
-    ~GPUManager();
+    // persistent runs batches of steps in one long-lived work-group, see
+    // simulateSteps in simulation.cl
+    explicit GPUManager(KernelMath math = KernelMath::Precise, bool persistent = false)
+        : math(math), persistent(persistent) {}
+    ~GPUManager() override;
 
     // Core functionality
-    void initialize(size_t numBalls, int screenWidth, int screenHeight);
-    void cleanup();
-    void updatePhysics(std::vector<Ball>& balls);
-    void setConstants(const SimConstants& consts) { constants = consts; }
+    void initialize(size_t numBalls, int screenWidth, int screenHeight) override;
+    void cleanup() override;
+    void updatePhysics(std::vector<Ball>& balls) override;
+    void advance(std::vector<Ball>& balls, int steps) override;
+    void setConstants(const SimConstants& consts) override { constants = consts; }
+    std::string name() const override {
+        if (persistent) return backend::OPENCL_PERSISTENT;
+        return math == KernelMath::Fast ? backend::OPENCL_FAST : backend::OPENCL;
+    }
+    StepStats lastStepStats() const override { return stepStats; }
 
 private:
     // Initialization helpers
@@ -25,8 +42,20 @@ private:
     void buildProgram();
     void createKernels();
     void createBuffers();
+    void buildStepPlan();
+    void createPersistentKernel();
+    void prewarmKernels();
+    // Enqueues the state, property (first time only) and constant uploads;
+    // returns the property bytes written
+    size_t uploadInputs(const std::vector<Ball>& balls, cl::Event& uploadStates,
+                        std::vector<cl::Event>& uploads);
     std::string loadKernelSource();
 
+    // Commands issued by updatePhysics, in enqueue order
+    enum DeviceCommand { Upload, Integrate, Collide, Readback, COUNT };
+    void traceDeviceCommands(const cl::Event* events);
+    static uint64_t commandDurationNs(const cl::Event& event);
+
     // OpenCL objects
     cl::Context context;
     cl::CommandQueue queue;
@@ -36,16 +65,35 @@ private:
     // Kernels
     cl::Kernel physicsKernel;
     cl::Kernel collisionKernel;
+    StepPlan plan;
 
-    // Buffers
-    cl::Buffer ballsBuffer;
+    // Persistent mode; the kernel stays empty when the scene is too large
+    cl::Kernel persistentKernel;
+    cl::Buffer nextStatesBuffer;
+    size_t persistentGroupSize{0};
+
+    // Buffers; hot state travels every step, properties only once
+    cl::Buffer statesBuffer;
+    cl::Buffer propertiesBuffer;
     cl::Buffer constantsBuffer;
+    cl::Buffer contactsBuffer;
 
     // State
+    KernelMath math;
+    bool persistent;
+    bool outOfOrder{false};  // queue runs commands as their events allow
     bool initialized{false};
     size_t numBalls{0};
     size_t workGroupSize{256};
     SimConstants constants;
+    StepStats stepStats;
+    cl_uint contactCount{0};
+
+    // Host staging for the split layout
+    std::vector<BallState> hostStates;
+    std::vector<BallProperties> hostProperties;
+    bool propertiesUploaded{false};
+    uint64_t uploadEnqueuedNs{0};  // host clock as the state upload was enqueued
 
     struct {
         int width{0};
@@ -0,0 +1,67 @@
+#ifndef BOUNCING_BALLS_HISTOGRAM_H
+#define BOUNCING_BALLS_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+
+namespace sim {
+
+// Fixed-memory latency histogram with log-linear buckets: every power of two
+// is split into 16 linear sub-buckets, so any recorded value is reported
+// within ~6% while the whole uint64 nanosecond range fits in < 1000 counters.
+// record() is wait-free and may be called from any thread.
+class LatencyHistogram {
+public:
+    struct Summary {
+        uint64_t count{0};
+        uint64_t p50{0};
+        uint64_t p99{0};
+        uint64_t p999{0};
+        uint64_t max{0};
+        double mean{0.0};
+    };
+
+    void record(uint64_t valueNs);
+    void reset();
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maxValue.load(std::memory_order_relaxed); }
+    uint64_t sumNs() const { return sum.load(std::memory_order_relaxed); }
+    // Number of recorded values whose bucket lies entirely at or below limitNs
+    uint64_t countAtOrBelow(uint64_t limitNs) const;
+    // Upper bound of the bucket holding the given quantile (0..1)
+    uint64_t percentile(double quantile) const;
+    Summary summary() const;
+
+private:
+    static constexpr int SUB_BITS = 4;
+    static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BITS;
+    static constexpr size_t BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BITS) * SUB_BUCKETS;
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(size_t index);
+
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maxValue{0};
+};
+
+// Tail-latency histograms for the main loops, in nanoseconds
+struct LatencyStats {
+    LatencyHistogram physicsStep;
+    LatencyHistogram broadphase;
+    LatencyHistogram narrowphase;
+    LatencyHistogram frame;
+    // Time from a snapshot being published by physics to being drawn
+    LatencyHistogram snapshotAge;
+
+    void reset();
+    void print(std::ostream& out) const;
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_HISTOGRAM_H
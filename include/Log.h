@@ -0,0 +1,97 @@
+#ifndef BOUNCING_BALLS_LOG_H
+#define BOUNCING_BALLS_LOG_H
+
+#include "Config.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <charconv>
+
+// Asynchronous logger. A log line is formatted into a fixed buffer on the
+// caller's stack and copied into the calling thread's lock-free ring; a
+// background thread drains all rings and does the terminal I/O. Producers
+// never block: when a ring is full the line is dropped and counted.
+//
+//   SIM_LOG_INFO << "Initializing " << numBalls << " balls";
+//
+// All output goes to stderr. Before log::start() and after log::stop() lines
+// are written synchronously, so static initializers and shutdown paths still
+// get their output.
+
+namespace sim {
+namespace log {
+
+enum class Level { Debug, Info, Warn, Error };
+
+void start();
+void stop();   // drains every ring before returning
+void submit(Level level, const char* text, size_t length);
+uint64_t droppedLines();
+
+// Runs the background writer for the lifetime of the object
+class Session {
+public:
+    Session() { start(); }
+    ~Session() { stop(); }
+    Session(const Session&) = delete;
+    Session& operator=(const Session&) = delete;
+};
+
+class Line {
+public:
+    explicit Line(Level level_) : level(level_) {}
+    ~Line() { submit(level, buffer, length); }
+    Line(const Line&) = delete;
+    Line& operator=(const Line&) = delete;
+
+    Line& operator<<(std::string_view text) {
+        append(text.data(), text.size());
+        return *this;
+    }
+    Line& operator<<(const char* text) { return *this << std::string_view(text ? text : "(null)"); }
+    Line& operator<<(const std::string& text) { return *this << std::string_view(text); }
+    // glGetString and friends
+    Line& operator<<(const unsigned char* text) { return *this << reinterpret_cast<const char*>(text); }
+    Line& operator<<(char c) {
+        append(&c, 1);
+        return *this;
+    }
+    Line& operator<<(bool value) { return *this << (value ? "true" : "false"); }
+
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    Line& operator<<(T value) {
+        char text[32];
+        if constexpr (std::is_integral_v<T>) {
+            const auto result = std::to_chars(text, text + sizeof(text), value);
+            append(text, static_cast<size_t>(result.ptr - text));
+        } else {
+            const int n = std::snprintf(text, sizeof(text), "%g", static_cast<double>(value));
+            append(text, n > 0 ? static_cast<size_t>(n) : 0);
+        }
+        return *this;
+    }
+
+private:
+    void append(const char* text, size_t n) {
+        const size_t room = sizeof(buffer) - length;
+        if (n > room) n = room;
+        std::char_traits<char>::copy(buffer + length, text, n);
+        length += n;
+    }
+
+    Level level;
+    size_t length{0};
+    char buffer[config::Log::LINE_CAPACITY];
+};
+
+} // namespace log
+} // namespace sim
+
+#define SIM_LOG_DEBUG ::sim::log::Line(::sim::log::Level::Debug)
+#define SIM_LOG_INFO ::sim::log::Line(::sim::log::Level::Info)
+#define SIM_LOG_WARN ::sim::log::Line(::sim::log::Level::Warn)
+#define SIM_LOG_ERROR ::sim::log::Line(::sim::log::Level::Error)
+
+#endif // BOUNCING_BALLS_LOG_H
@@ -0,0 +1,58 @@
+#ifndef BOUNCING_BALLS_MEMORY_H
+#define BOUNCING_BALLS_MEMORY_H
+
+#include "Config.h"
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+
+// Backing store for large physics arrays. Allocations of at least
+// config::Memory::LARGE_ALLOCATION_BYTES are mmap'd in whole 2 MB units and,
+// depending on the process-wide mode, advised for transparent huge pages or
+// taken from the explicit hugetlbfs pool (falling back to normal pages when
+// the pool is empty). Smaller allocations use operator new. Pages are not
+// touched here, so first-touch NUMA placement is left to the caller.
+
+namespace sim {
+namespace memory {
+
+enum class HugePages { Off, Transparent, Explicit };
+
+void setHugePages(HugePages mode);
+HugePages hugePages();
+// "off", "thp" or "explicit"; throws std::invalid_argument otherwise
+HugePages parseHugePages(const std::string& text);
+
+void* allocateLarge(size_t bytes);
+void freeLarge(void* pointer, size_t bytes);
+
+// std::allocator replacement routing through allocateLarge()
+template <typename T>
+struct LargeAllocator {
+    using value_type = T;
+
+    LargeAllocator() = default;
+    template <typename U>
+    LargeAllocator(const LargeAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        if (count > static_cast<size_t>(-1) / sizeof(T)) throw std::bad_array_new_length();
+        return static_cast<T*>(allocateLarge(count * sizeof(T)));
+    }
+    void deallocate(T* pointer, size_t count) { freeLarge(pointer, count * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const LargeAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const LargeAllocator<U>&) const { return false; }
+};
+
+// Vector for ball-sized arrays that may reach millions of elements
+template <typename T>
+using LargeVector = std::vector<T, LargeAllocator<T>>;
+
+} // namespace memory
+} // namespace sim
+
+#endif // BOUNCING_BALLS_MEMORY_H
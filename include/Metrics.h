@@ -0,0 +1,80 @@
+#ifndef BOUNCING_BALLS_METRICS_H
+#define BOUNCING_BALLS_METRICS_H
+
+#include "Histogram.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+// Monotonic counter; add() is a single relaxed atomic increment
+class MetricCounter {
+public:
+    void add(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+// Last-written value; set() is a single relaxed atomic store
+class MetricGauge {
+public:
+    void set(double v) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        value.store(bits, std::memory_order_relaxed);
+    }
+    double get() const {
+        const uint64_t bits = value.load(std::memory_order_relaxed);
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+// Named metrics rendered in the Prometheus text exposition format.
+// Registration takes a lock and is meant for startup; the returned
+// references stay valid for the registry's lifetime and are updated
+// lock-free from the hot loops.
+class MetricsRegistry {
+public:
+    MetricCounter& counter(const std::string& name, const std::string& help);
+    MetricGauge& gauge(const std::string& name, const std::string& help);
+    LatencyHistogram& histogram(const std::string& name, const std::string& help);
+    // Exposes a histogram owned elsewhere; it must outlive the registry
+    void attachHistogram(const std::string& name, const std::string& help,
+                         const LatencyHistogram& histogram);
+
+    void writePrometheus(std::ostream& out) const;
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+    struct Entry {
+        std::string name;
+        std::string help;
+        Type type;
+        const void* metric;
+    };
+
+    void add(const std::string& name, const std::string& help, Type type, const void* metric);
+
+    mutable std::mutex mutex;
+    std::vector<Entry> entries;
+    std::deque<MetricCounter> counters;
+    std::deque<MetricGauge> gauges;
+    std::deque<LatencyHistogram> histograms;
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_METRICS_H
@@ -0,0 +1,41 @@
+#ifndef BOUNCING_BALLS_METRICS_SERVER_H
+#define BOUNCING_BALLS_METRICS_SERVER_H
+
+#include "Metrics.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace sim {
+
+// Serves a MetricsRegistry in Prometheus text format from a background
+// thread. The endpoint is either "unix:/path/to.sock" or a TCP port bound to
+// 127.0.0.1 ("9100"). Every connection gets one HTTP/1.0 response, so both
+// Prometheus and `curl --unix-socket <path> http://localhost/metrics` work.
+class MetricsServer {
+public:
+    MetricsServer(const MetricsRegistry& registry, std::string endpoint);
+    ~MetricsServer();
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    void start();
+    void stop();
+    const std::string& endpoint() const { return endpointSpec; }
+
+private:
+    int openListener();
+    void serveLoop();
+    void handleClient(int client);
+
+    const MetricsRegistry& registry;
+    std::string endpointSpec;
+    std::string unixPath;  // non-empty for Unix domain sockets
+    int listenFd{-1};
+    std::atomic<bool> running{false};
+    std::thread thread;
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_METRICS_SERVER_H
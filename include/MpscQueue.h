@@ -0,0 +1,67 @@
+#ifndef BOUNCING_BALLS_MPSC_QUEUE_H
+#define BOUNCING_BALLS_MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+namespace sim {
+
+// Unbounded multi-producer/single-consumer queue (Vyukov). push() is one
+// atomic exchange plus a store and never blocks; pop() must only be called
+// from the single consumer thread. Producers allocate a node per item.
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() : head(&stub), tail(&stub) {}
+
+    ~MpscQueue() {
+        T discarded;
+        while (pop(discarded)) {}
+        if (tail != &stub) {
+            delete tail;
+        }
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node(std::move(value));
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    bool pop(T& out) {
+        Node* oldTail = tail;
+        Node* next = oldTail->next.load(std::memory_order_acquire);
+        if (!next) {
+            return false;
+        }
+        out = std::move(next->value);
+        tail = next;
+        if (oldTail != &stub) {
+            delete oldTail;
+        }
+        return true;
+    }
+
+    bool empty() const {
+        return tail->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        Node() = default;
+        explicit Node(T value_) : value(std::move(value_)) {}
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    Node stub;
+    std::atomic<Node*> head; // producers
+    Node* tail;              // consumer; points at the last consumed node
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_MPSC_QUEUE_H
@@ -0,0 +1,57 @@
+#ifndef BOUNCING_BALLS_PERF_COUNTERS_H
+#define BOUNCING_BALLS_PERF_COUNTERS_H
+
+#include <atomic>
+#include <cstdint>
+
+// Optional hardware counter attribution per simulation phase. Each thread
+// that enters a PhaseScope lazily opens its own perf_event_open group
+// (cycles, instructions, cache misses, branch misses) and the deltas are
+// summed per phase across threads. Disabled by default; when disabled or
+// unsupported (non-Linux, perf_event_paranoid, containers) a scope costs one
+// relaxed atomic load.
+
+namespace sim {
+namespace perf {
+
+enum class Phase { Integrate, Broadphase, Narrowphase, Publish, COUNT };
+enum Counter { Cycles, Instructions, CacheMisses, BranchMisses, COUNTER_COUNT };
+
+const char* phaseName(Phase phase);
+const char* counterName(Counter counter);
+
+struct PhaseTotals {
+    uint64_t values[COUNTER_COUNT]{};
+    uint64_t scopes{0};
+
+    double ipc() const {
+        return values[Cycles] ? static_cast<double>(values[Instructions]) / values[Cycles] : 0.0;
+    }
+};
+
+void setEnabled(bool enabled);
+bool enabled();
+
+// True once at least one thread managed to open its counters
+bool available();
+
+PhaseTotals totals(Phase phase);
+void resetTotals();
+
+class PhaseScope {
+public:
+    explicit PhaseScope(Phase phase);
+    ~PhaseScope();
+    PhaseScope(const PhaseScope&) = delete;
+    PhaseScope& operator=(const PhaseScope&) = delete;
+
+private:
+    Phase phase;
+    bool active{false};
+    uint64_t start[COUNTER_COUNT]{};
+};
+
+} // namespace perf
+} // namespace sim
+
+#endif // BOUNCING_BALLS_PERF_COUNTERS_H
@@ -0,0 +1,62 @@
+#ifndef BOUNCING_BALLS_PHYSICS_BACKEND_H
+#define BOUNCING_BALLS_PHYSICS_BACKEND_H
+
+#include "Types.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+namespace sim {
+
+// Measurements of the most recent step. Phase times are wall time in
+// nanoseconds; phases a backend does not have stay zero.
+struct StepStats {
+    uint64_t integrateNs{0};
+    uint64_t broadphaseNs{0};
+    uint64_t narrowphaseNs{0};
+    uint32_t contacts{0};          // touching ball pairs
+    uint64_t bytesTransferred{0};  // host <-> device traffic
+    uint32_t migrations{0};        // balls that changed spatial partition
+};
+
+// Common interface for everything that can advance the ball state one step.
+// updatePhysics() writes the new state back into the caller's vector every
+// step. Backends may keep their own copy between steps, so a caller that
+// edits the vector itself must call initialize() again before the next step.
+class PhysicsBackend {
+public:
+    virtual ~PhysicsBackend() = default;
+
+    virtual void initialize(size_t numBalls, int screenWidth, int screenHeight) = 0;
+    virtual void cleanup() = 0;
+    virtual void updatePhysics(std::vector<Ball>& balls) = 0;
+    // Runs `steps` steps and writes the state back once at the end;
+    // lastStepStats() then describes the batch. Backends that can keep
+    // several steps on the device override this.
+    virtual void advance(std::vector<Ball>& balls, int steps) {
+        for (int i = 0; i < steps; ++i) updatePhysics(balls);
+    }
+    virtual void setConstants(const SimConstants& consts) = 0;
+    virtual std::string name() const = 0;
+    virtual StepStats lastStepStats() const { return {}; }
+};
+
+// Backend names accepted on the command line
+namespace backend {
+    constexpr const char* OPENCL = "opencl";
+    constexpr const char* OPENCL_FAST = "opencl-fast";  // relaxed-math kernel build
+    constexpr const char* OPENCL_PERSISTENT = "opencl-persistent";  // batched steps, small scenes
+    constexpr const char* CPU = "cpu";               // threaded, one worker per core
+    constexpr const char* CPU_SERIAL = "cpu-serial"; // single worker reference
+    // Threaded CPU backend with another hot-state layout (BallLayout.h)
+    constexpr const char* CPU_SOA = "cpu-soa";
+    constexpr const char* CPU_AOSOA8 = "cpu-aosoa8";
+    constexpr const char* CPU_AOSOA16 = "cpu-aosoa16";
+}
+
+std::unique_ptr<PhysicsBackend> createBackend(const std::string& name);
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_PHYSICS_BACKEND_H
@@ -2,18 +2,34 @@
 #define BOUNCING_BALLS_RENDERER_H
 
 #include "Types.h"
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
 #include <vector>
 #include <string>
 
 namespace sim {
 
+// Live numbers shown by the performance overlay
+struct OverlayStats {
+    double fps{0.0};
+    double physicsRate{0.0};      // steps per second
+    double stepP50Ms{0.0};
+    double stepP99Ms{0.0};
+    double stepP999Ms{0.0};
+    size_t ballCount{0};
+    uint32_t contactsPerStep{0};
+    double transferMBps{0.0};     // host <-> device, 0 for host backends
+    std::string backendName;
+};
+
 class Renderer {
 public:
     Renderer(int width, int height);
     ~Renderer();
 
     bool initialize(size_t numBalls);
-    void render(const std::vector<Ball>& balls, double fps = 0.0);
+    // overlay == nullptr hides the performance overlay
+    void render(const std::vector<Ball>& balls, const OverlayStats* overlay = nullptr);
     bool shouldClose() const;
     GLFWwindow* getWindow() const { return window; }
 
@@ -34,8 +50,14 @@ private:
 
     void drawBalls(const std::vector<Ball>& balls);
     void drawCircle(float x, float y, float radius, uint32_t color, float alpha);
-    void drawText(const std::string& text, float x, float y, float scale); // Added back
-    void renderFPS(double fps); // Added back
+    // Text is queued by drawText/drawPanel and drawn by flushText in one call
+    void createGlyphAtlas();
+    void drawText(const std::string& text, float x, float y, float scale);
+    void drawPanel(float x, float y, float w, float h, const GLubyte color[4]);
+    void pushQuad(float x0, float y0, float x1, float y1,
+                  float u0, float v0, float u1, float v1, const GLubyte color[4]);
+    void flushText();
+    void renderOverlay(const OverlayStats& overlay);
 
     static void framebufferSizeCallback(GLFWwindow* window, int width, int height);
 
@@ -46,8 +68,19 @@ private:
     // Data
     size_t numBalls;
 
+    // Glyph atlas and the pending text batch
+    struct TextVertex {
+        float x, y;
+        float u, v;
+        GLubyte color[4];
+    };
+    GLuint glyphTexture{0};
+    std::vector<TextVertex> textBatch;
+
     static constexpr int CIRCLE_SEGMENTS = 32;
-    static constexpr float TEXT_SCALE = 0.15f;
+    static constexpr float TEXT_SCALE = 1.0f;
+    static constexpr int ATLAS_COLUMNS = 16;
+    static constexpr int ATLAS_SIZE = 128;
     static constexpr float PI = 3.14159265358979323846f;
 };
 
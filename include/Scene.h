@@ -0,0 +1,21 @@
+#ifndef BOUNCING_BALLS_SCENE_H
+#define BOUNCING_BALLS_SCENE_H
+
+#include "Types.h"
+#include <vector>
+#include <cstdint>
+
+namespace sim {
+
+// Default physics constants for a screen of the given size
+SimConstants makeConstants(float screenWidth, float screenHeight);
+
+// Random initial ball layout; the same seed always produces the same scene
+std::vector<Ball> generateBalls(int numBalls, float screenWidth, float screenHeight, uint32_t seed);
+
+// Kinetic plus gravitational potential energy (positive Y is down)
+double totalEnergy(const std::vector<Ball>& balls, const SimConstants& constants);
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_SCENE_H
@@ -0,0 +1,130 @@
+#ifndef BOUNCING_BALLS_SCENE_SERVER_H
+#define BOUNCING_BALLS_SCENE_SERVER_H
+
+#include "WorkerPool.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sim {
+
+// Binary protocol of the scene server. Every request and reply is one
+// wire frame (Wire.h). A request starts with its u8 Request type; a reply
+// starts with a u8 Status, followed by the payload on Ok or a u8-length
+// message otherwise.
+namespace session {
+
+enum class Request : uint8_t {
+    Create = 1,  // str backend, u32 balls, f32 width, f32 height, u32 seed -> u32 session
+    Step,        // u32 session, u32 steps -> u64 step the queued work ends at
+    Snapshot,    // u32 session -> u64 step, u32 count, count * BallRecord
+    Spawn,       // u32 session, u32 count, u32 seed -> u32 balls
+    SetGravity,  // u32 session, f32 gravity -> (nothing)
+    Status,      // u32 session -> u64 step, u64 pending steps, u32 balls
+    Destroy,     // u32 session -> (nothing)
+};
+
+enum class Status : uint8_t {
+    Ok = 0,
+    BadRequest,
+    UnknownSession,
+    BackendError,  // the session stays failed; destroy it
+    Busy,          // session limit reached
+};
+
+// One ball in a snapshot reply
+struct BallRecord {
+    float x, y;
+    float vx, vy;
+    float radius;
+    uint32_t color;
+};
+static_assert(sizeof(BallRecord) == 24, "BallRecord is sent as is");
+
+} // namespace session
+
+// Hosts many independent scenes in one process and serves them over a
+// Unix domain socket. Stepping is asynchronous: a Step request queues work
+// and the scheduler thread hands every session with queued steps one
+// quantum per round. Single-threaded sessions (cpu-serial) of a round run
+// side by side on a shared worker pool; sessions on backends that are
+// parallel on their own (cpu, opencl*) take their quantum one at a time
+// on the scheduler thread, so they never compete with each other.
+//
+// Only the scheduler touches backends. Create, Spawn and SetGravity run on
+// it between rounds; Create and Spawn are answered when they finish, and
+// their client's later requests wait until then so replies stay in order.
+// Snapshot and Status read each session's latest published state, so the
+// I/O thread never waits for a quantum or a backend build.
+class SceneServer {
+public:
+    explicit SceneServer(std::string socketPath);
+    ~SceneServer();
+    SceneServer(const SceneServer&) = delete;
+    SceneServer& operator=(const SceneServer&) = delete;
+
+    void start();
+    void stop();
+    const std::string& path() const { return socketPath; }
+    size_t sessionCount() const;
+
+private:
+    struct Session;
+    struct Client {
+        uint64_t id{0};
+        int fd{-1};
+        std::string input;
+        std::string output;
+        bool awaiting{false};  // a deferred reply is outstanding
+    };
+
+    int openListener();
+    void serveLoop();
+    bool readClient(Client& client);
+    bool handleInput(Client& client);
+    bool flushClient(Client& client);
+    // Reply to the request, or empty when it was handed to the scheduler
+    std::string handle(Client& client, const char* payload, size_t size);
+
+    // Runs `job` on the scheduler thread before its next round
+    void postControl(std::function<void()> job);
+    // Hands a deferred reply back to the I/O thread
+    void complete(uint64_t clientId, std::string reply);
+    std::string createSession(const std::string& backendName, uint32_t balls, float width,
+                              float height, uint32_t seed);
+    std::string spawn(Session& session, uint32_t count, uint32_t seed);
+
+    void scheduleLoop();
+    void runQuantum(Session& session);
+    std::shared_ptr<Session> find(uint32_t id) const;
+
+    std::string socketPath;
+    int listenFd{-1};
+    std::atomic<bool> running{false};
+    std::thread ioThread;
+    std::thread schedulerThread;
+
+    WorkerPool pool;
+
+    mutable std::mutex sessionsMutex;
+    std::condition_variable workQueued;
+    std::map<uint32_t, std::shared_ptr<Session>> sessions;  // guarded by sessionsMutex
+    uint32_t nextSessionId{1};                              // guarded by sessionsMutex
+    std::deque<std::function<void()>> controls;             // guarded by sessionsMutex
+
+    std::mutex completedMutex;
+    std::vector<std::pair<uint64_t, std::string>> completed;  // guarded by completedMutex
+    int wakeFds[2]{-1, -1};  // pipe that wakes the I/O thread for completed replies
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_SCENE_SERVER_H
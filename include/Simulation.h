@@ -3,41 +3,100 @@
 
 #include "Types.h"
 #include "Config.h"
-#include "GPUManager.h"
+#include "PhysicsBackend.h"
 #include "Renderer.h"
+#include "Histogram.h"
+#include "Metrics.h"
+#include "SnapshotBuffer.h"
+#include "MpscQueue.h"
+#include "Affinity.h"
 #include <vector>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <memory>
+#include <string>
+#include <functional>
+#include <random>
 
 namespace sim {
 
 class Simulation {
 public:
-    Simulation(int numBalls, float screenWidth, float screenHeight);
+    Simulation(int numBalls, float screenWidth, float screenHeight,
+               const std::string& backendName = backend::OPENCL);
     ~Simulation();
 
     void start();
     void stop();
-    void pause() { paused = true; }
-    void resume() { paused = false; }
     bool isPaused() const { return paused; }
+
+    // Commands run on the physics thread at the next step boundary, so they
+    // may change any simulation state. post() is lock-free and may be called
+    // from any thread (input callbacks, scripting, remote control).
+    using Command = std::function<void(Simulation&)>;
+    void post(Command command);
+
+    // Convenience controls built on post()
+    void pause();
+    void resume();
+    void togglePause();
+    void reset();
+    void spawnBalls(int count);
+    void setGravity(float gravity);
+    void adjustGravity(float delta);
+    // Moves the running scene to another backend; on failure the current
+    // one keeps running
+    void switchBackend(const std::string& name);
+    // Between the failover backend and OpenCL (or the startup backend)
+    void toggleBackend();
     bool shouldClose() const { return renderer.shouldClose(); }
 
+    // Name of the backend currently stepping; any thread
+    std::string backendName() const;
+
+    // Step/frame latency distributions since start
+    const LatencyStats& latencyStats() const { return stats; }
+
+    // Counters, gauges and histograms fed by the physics and render loops
+    const MetricsRegistry& metrics() const { return metricsRegistry; }
+
+    // Folds the threads' /proc scheduler counters into the metrics. Reads
+    // files, so it runs on the main thread rather than in a frame.
+    void sampleSchedMetrics();
+
 private:
     void initializeBalls(int numBalls);
+    void registerMetrics();
+    void drainCommands();
+    void rebuildBackend();
+    bool swapBackend(const std::string& name, const char* reason);
+    // One step, moving to the failover backend if it throws; false when
+    // no backend could take the step
+    bool stepOrFailover();
+    // Clears running and closes the window when no backend is usable
+    void stopOnPhysicsFailure();
+    void recordBackendStep(uint64_t stepNs);
     void physicsLoop();
     void renderLoop();
     static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
     // Core components
     SimConstants constants;
-    GPUManager gpuManager;
+    std::unique_ptr<PhysicsBackend> physics;
     Renderer renderer;
 
+    // Backend bookkeeping (physics thread), for failover and A/B comparison
+    std::string startupBackend;
+    uint64_t backendSteps{0};
+    uint64_t backendStepNs{0};
+    mutable std::mutex backendNameMutex;
+    std::string activeBackend;
+
     // Thread management
     std::atomic<bool> running{false};
     std::atomic<bool> paused{false};
+    std::atomic<bool> overlayVisible{false};
     std::thread physicsThread;
     std::thread renderThread;
 
@@ -45,8 +104,48 @@ private:
     float screenWidth;
     float screenHeight;
 
-    // Balls data
+    // Start of construction, for time-to-first-frame
+    uint64_t createdNs{0};
+
+    // Balls data, owned by the physics thread once started
     std::vector<Ball> balls;
+    uint64_t stepCount{0};
+
+    // Pending control commands and the RNG they use (physics thread only)
+    MpscQueue<Command> commands;
+    std::mt19937 controlRng{std::random_device{}()};
+
+    // Physics -> render handoff
+    SnapshotBuffer snapshots;
+
+    LatencyStats stats;
+
+    // Inputs for the performance overlay
+    LatencyHistogram recentSteps;           // reset every overlay refresh
+    std::atomic<uint32_t> lastContacts{0};
+    std::atomic<uint64_t> bytesTransferred{0};
+
+    // Exported metrics; pointers are owned by metricsRegistry
+    MetricsRegistry metricsRegistry;
+    MetricCounter* stepsMetric{nullptr};
+    MetricCounter* framesMetric{nullptr};
+    MetricCounter* contactsMetric{nullptr};
+    MetricCounter* migrationsMetric{nullptr};
+    MetricCounter* bytesMetric{nullptr};
+    MetricCounter* backendSwitchesMetric{nullptr};
+    MetricCounter* failoversMetric{nullptr};
+    MetricGauge* fpsMetric{nullptr};
+    MetricGauge* physicsRateMetric{nullptr};
+    MetricGauge* ballsMetric{nullptr};
+    MetricGauge* firstFrameMetric{nullptr};
+
+    struct SchedMetrics {
+        MetricCounter* migrations{nullptr};
+        MetricCounter* voluntarySwitches{nullptr};
+        MetricCounter* involuntarySwitches{nullptr};
+        affinity::SchedStats last;
+    };
+    SchedMetrics schedMetrics[static_cast<int>(affinity::Role::COUNT)];
 
     // Constants
     static constexpr float PHYSICS_RATE = config::Physics::RATE;
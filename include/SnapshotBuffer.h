@@ -0,0 +1,42 @@
+#ifndef BOUNCING_BALLS_SNAPSHOT_BUFFER_H
+#define BOUNCING_BALLS_SNAPSHOT_BUFFER_H
+
+#include "Types.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace sim {
+
+// Ball state handed from the physics thread to readers
+struct Snapshot {
+    std::vector<Ball> balls;
+    uint64_t step{0};
+    uint64_t publishNs{0}; // trace::nowNs() at publication
+};
+
+// Lock-free triple buffer: one producer publishes whole snapshots, one
+// consumer always sees the most recent complete one. Neither side waits.
+class SnapshotBuffer {
+public:
+    // Producer side: copies balls into the back slot and swaps it in
+    void publish(const std::vector<Ball>& balls, uint64_t step);
+
+    // Consumer side: latest published snapshot (unchanged if none is newer).
+    // The reference stays valid until the next call to acquire().
+    const Snapshot& acquire();
+    bool hasNew() const { return (middle.load(std::memory_order_acquire) & DIRTY) != 0; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t DIRTY = 0x4;
+
+    Snapshot slots[3];
+    uint8_t back{0};                  // producer only
+    uint8_t front{1};                 // consumer only
+    std::atomic<uint8_t> middle{2};
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_SNAPSHOT_BUFFER_H
@@ -0,0 +1,111 @@
+#ifndef BOUNCING_BALLS_SNAPSHOT_STREAM_H
+#define BOUNCING_BALLS_SNAPSHOT_STREAM_H
+
+#include "Types.h"
+#include "SnapshotBuffer.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sim {
+
+// Viewer protocol on the stream socket, one wire frame (Wire.h) per
+// message. Positions travel as integers in units of
+// config::Stream::POSITION_QUANTUM.
+namespace stream {
+
+enum class Message : uint8_t {
+    Hello = 1,  // viewer -> stream: f32 frames per second
+    Keyframe,   // u64 step, u32 count, count * {i32 x, i32 y, f32 radius, u32 color}
+    Delta,      // u64 step, u32 count, count * {i16 dx, i16 dy} from the previous frame sent
+};
+
+} // namespace stream
+
+// Streams a headless run to viewers on a Unix domain socket. Each viewer
+// asks for a frame rate; it gets a keyframe first and then quantized
+// position deltas against the last frame it was sent. publish() only
+// copies into a triple buffer, so the simulation never waits on a viewer:
+// a frame that falls due while the viewer's previous one is still queued
+// in the socket is dropped, and the next delta covers both.
+class SnapshotStream {
+public:
+    explicit SnapshotStream(std::string socketPath);
+    ~SnapshotStream();
+    SnapshotStream(const SnapshotStream&) = delete;
+    SnapshotStream& operator=(const SnapshotStream&) = delete;
+
+    void start();
+    void stop();
+    // Single producer
+    void publish(const std::vector<Ball>& balls, uint64_t step);
+
+private:
+    struct Viewer {
+        int fd{-1};
+        std::string input;
+        std::string output;
+        uint64_t intervalNs{0};  // 0 until the viewer said hello
+        uint64_t nextSendNs{0};
+        uint64_t lastStep{0};
+        bool keyed{false};
+        int framesSinceKey{0};
+        std::vector<int32_t> baseX;  // quantized positions of the last frame sent
+        std::vector<int32_t> baseY;
+        uint64_t frames{0};
+        uint64_t keyframes{0};
+        uint64_t dropped{0};
+        uint64_t bytes{0};
+    };
+
+    int openListener();
+    void serveLoop();
+    bool readViewer(Viewer& viewer);
+    bool flushViewer(Viewer& viewer);
+    void encode(Viewer& viewer, const Snapshot& snapshot);
+    void closeViewer(Viewer& viewer);
+
+    std::string socketPath;
+    int listenFd{-1};
+    std::atomic<bool> running{false};
+    std::thread thread;
+    SnapshotBuffer snapshots;
+};
+
+// Viewer end of a SnapshotStream: rebuilds the balls from the frames
+class StreamClient {
+public:
+    explicit StreamClient(std::string socketPath);
+    ~StreamClient();
+    StreamClient(const StreamClient&) = delete;
+    StreamClient& operator=(const StreamClient&) = delete;
+
+    // Connects and asks for `fps` frames per second; throws on failure
+    void connect(double fps);
+    // Waits up to timeoutMs for data and applies every complete frame.
+    // True when the state changed; throws once the stream has ended.
+    bool poll(int timeoutMs);
+
+    const std::vector<Ball>& balls() const { return state; }
+    uint64_t step() const { return lastStep; }
+    uint64_t bytesReceived() const { return received; }
+
+private:
+    void apply(const char* payload, size_t size);
+
+    std::string socketPath;
+    int fd{-1};
+    std::string input;
+    std::vector<Ball> state;
+    std::vector<int32_t> positionX;  // quantized, as on the wire
+    std::vector<int32_t> positionY;
+    bool keyed{false};
+    uint64_t lastStep{0};
+    uint64_t received{0};
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_SNAPSHOT_STREAM_H
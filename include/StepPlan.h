@@ -0,0 +1,57 @@
+#ifndef BOUNCING_BALLS_STEP_PLAN_H
+#define BOUNCING_BALLS_STEP_PLAN_H
+
+#include "Types.h"
+#include <memory>
+#include <vector>
+
+namespace sim {
+
+// The kernel launches of one GPU step, built once per configuration (ball
+// count, buffers, work-group size) and replayed every step. The kernels
+// arrive with their arguments already bound, so a replay only enqueues.
+// When the device offers cl_khr_command_buffer both launches are recorded
+// into a finalized command buffer and a replay is a single enqueue.
+class StepPlan {
+public:
+    StepPlan();
+    ~StepPlan();
+
+    StepPlan(const StepPlan&) = delete;
+    StepPlan& operator=(const StepPlan&) = delete;
+
+    void build(const cl::Device& device, const cl::CommandQueue& queue,
+               const cl::Kernel& integrate, const cl::Kernel& collide,
+               size_t globalSize, size_t localSize);
+    void reset();
+
+    // Enqueues integrate after integrateDeps and collide after integrate and
+    // collideDeps. A recorded plan reports its one event for both.
+    void enqueue(const cl::CommandQueue& queue, const std::vector<cl::Event>& integrateDeps,
+                 const std::vector<cl::Event>& collideDeps, cl::Event& integrated,
+                 cl::Event& collided) const;
+
+    bool built() const { return ready; }
+    // True when replays go through a command buffer
+    bool recorded() const { return commandBuffer != nullptr; }
+
+private:
+    struct Extension;
+
+    bool record(const cl::Device& device, const cl::CommandQueue& queue, size_t globalSize,
+                size_t localSize);
+
+    cl::Kernel integrateKernel;
+    cl::Kernel collideKernel;
+    cl::NDRange global;
+    cl::NDRange local;
+    bool ready{false};
+
+    // cl_command_buffer_khr and the extension entry points it was made with
+    void* commandBuffer{nullptr};
+    std::unique_ptr<Extension> extension;
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_STEP_PLAN_H
@@ -0,0 +1,69 @@
+#ifndef BOUNCING_BALLS_TRACE_H
+#define BOUNCING_BALLS_TRACE_H
+
+#include <cstdint>
+#include <string>
+
+// Scoped timeline instrumentation written as Chrome trace-event JSON
+// (load the file in chrome://tracing or https://ui.perfetto.dev).
+//
+// Zones compile to nothing unless SIM_ENABLE_TRACING is defined
+// (cmake -DBOUNCING_BALLS_ENABLE_TRACING=ON). Each thread appends to its own
+// fixed-size buffer, so recording never takes a lock.
+
+namespace sim {
+namespace trace {
+
+#ifdef SIM_ENABLE_TRACING
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+// Nanoseconds on the steady clock since the first call in this process
+uint64_t nowNs();
+
+// Names the calling thread's track in the timeline
+void setThreadName(const char* name);
+
+// Appends a complete event; name must have static storage duration
+void recordSpan(const char* name, uint64_t startNs, uint64_t endNs);
+
+// Appends a span to a synthetic track (e.g. an OpenCL device queue)
+void recordTrackSpan(const char* track, const char* name, uint64_t startNs, uint64_t endNs);
+
+// Appends a zero-length marker on the calling thread's track
+void recordInstant(const char* name);
+
+// Writes every recorded event; safe to call while other threads record
+bool writeChromeTrace(const std::string& path);
+
+class Scope {
+public:
+    explicit Scope(const char* name_) : name(name_), start(nowNs()) {}
+    ~Scope() { recordSpan(name, start, nowNs()); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+} // namespace trace
+} // namespace sim
+
+#define SIM_TRACE_CONCAT_INNER(a, b) a##b
+#define SIM_TRACE_CONCAT(a, b) SIM_TRACE_CONCAT_INNER(a, b)
+
+#ifdef SIM_ENABLE_TRACING
+#define SIM_TRACE_SCOPE(name) ::sim::trace::Scope SIM_TRACE_CONCAT(simTraceScope_, __LINE__)(name)
+#define SIM_TRACE_THREAD(name) ::sim::trace::setThreadName(name)
+#define SIM_TRACE_INSTANT(name) ::sim::trace::recordInstant(name)
+#else
+#define SIM_TRACE_SCOPE(name) ((void)0)
+#define SIM_TRACE_THREAD(name) ((void)0)
+#define SIM_TRACE_INSTANT(name) ((void)0)
+#endif
+
+#endif // BOUNCING_BALLS_TRACE_H
@@ -0,0 +1,55 @@
+#ifndef BOUNCING_BALLS_TRANSPORT_H
+#define BOUNCING_BALLS_TRANSPORT_H
+
+#include <string>
+#include <vector>
+
+namespace sim {
+
+// Message passing between the ranks of a distributed run. Ranks are
+// numbered 0..size()-1. The simulation only uses exchange(), so a transport
+// over another medium (TCP between nodes, shared memory) implements that one
+// call.
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+
+    // Sends outgoing[i] to peers[i] and returns the one message each of
+    // those peers sends back, in the same order. Every peer calls exchange()
+    // with this rank in its list, all at the same time, so an implementation
+    // must not block on a send before it has started receiving.
+    virtual std::vector<std::string> exchange(const std::vector<int>& peers,
+                                              const std::vector<std::string>& outgoing) = 0;
+};
+
+// Ranks on one host connected pairwise by Unix domain socket pairs. The
+// launcher creates the pairs (createMesh) before spawning the ranks; each
+// rank then gets the descriptors of its row.
+class LocalSocketTransport : public Transport {
+public:
+    // fds[peer] is the socket to that peer, -1 for this rank itself
+    LocalSocketTransport(int rank, std::vector<int> fds);
+    ~LocalSocketTransport() override;
+    LocalSocketTransport(const LocalSocketTransport&) = delete;
+    LocalSocketTransport& operator=(const LocalSocketTransport&) = delete;
+
+    // mesh[a][b] is rank a's end of the pair shared with rank b
+    static std::vector<std::vector<int>> createMesh(int ranks);
+
+    int rank() const override { return self; }
+    int size() const override { return static_cast<int>(peerFds.size()); }
+    std::vector<std::string> exchange(const std::vector<int>& peers,
+                                      const std::vector<std::string>& outgoing) override;
+
+private:
+    int self;
+    std::vector<int> peerFds;
+    std::vector<std::string> backlog;  // bytes read past the last frame, per peer
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_TRANSPORT_H
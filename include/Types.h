@@ -6,8 +6,7 @@
 #define CL_HPP_ENABLE_EXCEPTIONS
 
 #include <CL/opencl.hpp>
-#include <GL/glew.h>
-#include <GLFW/glfw3.h>
+#include <cstdint>
 
 namespace sim {
 
@@ -19,16 +18,45 @@ struct alignas(8) Vec2 {
     Vec2(float x_, float y_) : x(x_), y(y_) {}
 };
 
-// Ball structure matching OpenCL kernel structure
+// Complete ball as the application sees it. The backends split it into
+// the hot and cold records below.
 struct alignas(32) Ball {
-    Vec2 position;    // 8 bytes
-    Vec2 velocity;    // 8 bytes
-    float radius;     // 4 bytes
-    float mass;       // 4 bytes
-    uint32_t color;   // 4 bytes
-    uint32_t padding; // 4 bytes for alignment
+    Vec2 position;     // 8 bytes
+    Vec2 velocity;     // 8 bytes
+    float radius;      // 4 bytes
+    float mass;        // 4 bytes
+    uint32_t color;    // 4 bytes
+    float inverseMass; // 4 bytes, 1 / mass
 };
 
+// Hot record matching the OpenCL BallState: everything a step writes.
+// 16 bytes, so four balls share a cache line.
+struct alignas(16) BallState {
+    Vec2 position;
+    Vec2 velocity;
+};
+
+// Cold record matching the OpenCL BallProperties: constant per ball
+struct alignas(16) BallProperties {
+    float radius;
+    float inverseMass;
+    float mass;
+    uint32_t color;
+};
+
+inline BallState stateOf(const Ball& ball) {
+    return {ball.position, ball.velocity};
+}
+
+inline BallProperties propertiesOf(const Ball& ball) {
+    return {ball.radius, ball.inverseMass, ball.mass, ball.color};
+}
+
+inline void storeState(Ball& ball, const BallState& state) {
+    ball.position = state.position;
+    ball.velocity = state.velocity;
+}
+
 // Simulation constants matching OpenCL kernel structure
 struct alignas(32) SimConstants {
     float dt;
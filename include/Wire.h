@@ -0,0 +1,106 @@
+#ifndef BOUNCING_BALLS_WIRE_H
+#define BOUNCING_BALLS_WIRE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace sim {
+namespace wire {
+
+// Frames on the local sockets are a u32 payload length followed by the
+// payload. Fields are packed little-endian with no padding; the peers are
+// processes on the same host, so values are copied in host byte order.
+constexpr size_t FRAME_HEADER_BYTES = sizeof(uint32_t);
+
+class Writer {
+public:
+    // Reserves the length prefix; finish() fills it in
+    Writer() { data.resize(FRAME_HEADER_BYTES); }
+
+    template <typename T>
+    Writer& put(T value) {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "scalar fields only");
+        const size_t at = data.size();
+        data.resize(at + sizeof(T));
+        std::memcpy(&data[at], &value, sizeof(T));
+        return *this;
+    }
+
+    Writer& putBytes(const void* bytes, size_t size) {
+        data.append(static_cast<const char*>(bytes), size);
+        return *this;
+    }
+
+    // u8 length, so names only
+    Writer& putString(const std::string& text) {
+        const size_t size = std::min<size_t>(text.size(), UINT8_MAX);
+        put(static_cast<uint8_t>(size));
+        return putBytes(text.data(), size);
+    }
+
+    std::string& finish() {
+        const uint32_t length = static_cast<uint32_t>(data.size() - FRAME_HEADER_BYTES);
+        std::memcpy(&data[0], &length, sizeof(length));
+        return data;
+    }
+
+private:
+    std::string data;
+};
+
+// Reads one frame payload; running past its end throws
+class Reader {
+public:
+    Reader(const char* payload, size_t size) : cursor(payload), end(payload + size) {}
+
+    template <typename T>
+    T get() {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "scalar fields only");
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    const char* getBytes(size_t size) { return take(size); }
+
+    std::string getString() {
+        const size_t size = get<uint8_t>();
+        return std::string(take(size), size);
+    }
+
+    size_t remaining() const { return static_cast<size_t>(end - cursor); }
+
+private:
+    const char* take(size_t size) {
+        if (remaining() < size) throw std::out_of_range("truncated frame");
+        const char* at = cursor;
+        cursor += size;
+        return at;
+    }
+
+    const char* cursor;
+    const char* end;
+};
+
+// Length of the frame at the front of buffer, or 0 while it is incomplete
+inline size_t completeFrame(const std::string& buffer) {
+    if (buffer.size() < FRAME_HEADER_BYTES) return 0;
+    uint32_t length;
+    std::memcpy(&length, buffer.data(), sizeof(length));
+    return buffer.size() >= FRAME_HEADER_BYTES + length ? FRAME_HEADER_BYTES + length : 0;
+}
+
+inline uint32_t frameLength(const std::string& buffer) {
+    uint32_t length = 0;
+    if (buffer.size() >= FRAME_HEADER_BYTES) std::memcpy(&length, buffer.data(), sizeof(length));
+    return length;
+}
+
+} // namespace wire
+} // namespace sim
+
+#endif // BOUNCING_BALLS_WIRE_H
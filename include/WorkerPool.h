@@ -0,0 +1,50 @@
+#ifndef BOUNCING_BALLS_WORKER_POOL_H
+#define BOUNCING_BALLS_WORKER_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+namespace sim {
+
+// Fixed set of persistent worker threads used by the CPU physics backend.
+// parallelFor splits [0, count) into one contiguous range per worker, so the
+// same index always lands on the same worker for a given count. A pool of
+// one runs its jobs inline on the calling thread and starts no thread, so
+// many single-threaded scenes can share a host (or an outer pool).
+class WorkerPool {
+public:
+    using RangeFn = std::function<void(size_t begin, size_t end, size_t worker)>;
+
+    explicit WorkerPool(size_t numThreads);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Runs fn over [0, count) and blocks until every worker has finished
+    void parallelFor(size_t count, const RangeFn& fn);
+    size_t size() const { return numWorkers; }
+
+private:
+    void workerLoop(size_t worker);
+
+    size_t numWorkers;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable startCv;
+    std::condition_variable doneCv;
+
+    // Current job, guarded by mutex
+    const RangeFn* job{nullptr};
+    size_t jobCount{0};
+    size_t generation{0};
+    size_t pending{0};
+    bool stopping{false};
+};
+
+} // namespace sim
+
+#endif // BOUNCING_BALLS_WORKER_POOL_H
@@ -0,0 +1,236 @@
+#include "Affinity.h"
+#include "Log.h"
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace sim {
+namespace affinity {
+
+namespace {
+
+struct ThreadEntry {
+    Role role;
+    long tid;
+    SchedStats last;
+};
+
+struct State {
+    std::mutex mutex;
+    Placement placement;
+    std::vector<int> cpus[static_cast<int>(Role::COUNT)];
+    std::vector<ThreadEntry> threads;
+    SchedStats retired[static_cast<int>(Role::COUNT)];
+};
+
+void accumulate(SchedStats& total, const SchedStats& stats) {
+    total.migrations += stats.migrations;
+    total.voluntarySwitches += stats.voluntarySwitches;
+    total.involuntarySwitches += stats.involuntarySwitches;
+}
+
+long currentTid() {
+#ifdef __linux__
+    return static_cast<long>(syscall(SYS_gettid));
+#else
+    return 0;
+#endif
+}
+
+State& state() {
+    static State instance;
+    return instance;
+}
+
+std::vector<int> expandRange(const std::string& item) {
+    const size_t dash = item.find('-');
+    const int first = std::stoi(item.substr(0, dash));
+    const int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+    if (first < 0 || last < first) {
+        throw std::invalid_argument("Bad CPU range: " + item);
+    }
+
+    std::vector<int> cpus;
+    for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+#ifdef __linux__
+// Reads "key : value" pairs from a /proc file; missing keys leave value alone
+void readProcField(const std::string& path, const char* key, uint64_t& value) {
+    std::ifstream in(path);
+    const size_t keyLength = std::strlen(key);
+    for (std::string line; std::getline(in, line);) {
+        if (line.compare(0, keyLength, key) != 0) continue;
+        const size_t colon = line.find(':', keyLength);
+        if (colon == std::string::npos) continue;
+        value = std::stoull(line.substr(colon + 1));
+        return;
+    }
+}
+
+void readThreadStats(long tid, SchedStats& stats) {
+    const std::string task = "/proc/self/task/" + std::to_string(tid);
+    // Context switches are always in status; migrations need CONFIG_SCHED_DEBUG
+    readProcField(task + "/status", "voluntary_ctxt_switches", stats.voluntarySwitches);
+    readProcField(task + "/status", "nonvoluntary_ctxt_switches", stats.involuntarySwitches);
+    readProcField(task + "/sched", "se.nr_migrations", stats.migrations);
+}
+
+void pinCurrentThread(const std::vector<int>& cpus, Role role, size_t index) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+
+    const int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (error != 0) {
+        SIM_LOG_WARN << "Could not pin " << roleName(role) << " thread " << index
+                     << ": " << std::strerror(error);
+    }
+}
+
+void setRealtimePriority(int priority) {
+    sched_param param{};
+    param.sched_priority = priority;
+    const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error != 0) {
+        // EPERM without CAP_SYS_NICE or an rtprio limit
+        SIM_LOG_WARN << "Could not set SCHED_FIFO priority " << priority
+                     << " for physics thread: " << std::strerror(error);
+    } else {
+        SIM_LOG_INFO << "Physics thread running SCHED_FIFO priority " << priority;
+    }
+}
+#endif
+
+} // namespace
+
+const char* roleName(Role role) {
+    switch (role) {
+        case Role::Physics: return "physics";
+        case Role::Render: return "render";
+        case Role::Worker: return "worker";
+        default: return "unknown";
+    }
+}
+
+std::vector<int> parseCpuList(const std::string& text) {
+    if (text.compare(0, 4, "node") == 0) {
+        const int node = std::stoi(text.substr(4));
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string list;
+        if (!std::getline(in, list)) {
+            throw std::invalid_argument("Unknown NUMA node: " + text);
+        }
+        return parseCpuList(list);
+    }
+
+    std::vector<int> cpus;
+    std::istringstream items(text);
+    for (std::string item; std::getline(items, item, ',');) {
+        if (item.empty()) continue;
+        const auto range = expandRange(item);
+        cpus.insert(cpus.end(), range.begin(), range.end());
+    }
+    if (cpus.empty()) {
+        throw std::invalid_argument("Empty CPU list: " + text);
+    }
+    return cpus;
+}
+
+void configure(const Placement& placement) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.placement = placement;
+
+    const std::string* lists[] = {&placement.physicsCpus, &placement.renderCpus, &placement.workerCpus};
+    for (int role = 0; role < static_cast<int>(Role::COUNT); ++role) {
+        s.cpus[role] = lists[role]->empty() ? std::vector<int>{} : parseCpuList(*lists[role]);
+    }
+}
+
+void enterThread(Role role, size_t index) {
+    State& s = state();
+    std::vector<int> cpus;
+    int priority = 0;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        cpus = s.cpus[static_cast<int>(role)];
+        priority = role == Role::Physics ? s.placement.physicsPriority : 0;
+        s.threads.push_back({role, currentTid(), {}});
+    }
+
+#ifdef __linux__
+    if (!cpus.empty()) {
+        // Workers get one CPU each so static partitions keep their caches
+        if (role == Role::Worker) {
+            cpus = {cpus[index % cpus.size()]};
+        }
+        pinCurrentThread(cpus, role, index);
+    }
+    if (priority > 0) {
+        setRealtimePriority(priority);
+    }
+#else
+    (void)index;
+    (void)priority;
+#endif
+}
+
+void leaveThread() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    const long tid = currentTid();
+    for (auto it = s.threads.begin(); it != s.threads.end(); ++it) {
+        if (it->tid != tid) continue;
+#ifdef __linux__
+        readThreadStats(tid, it->last);
+#endif
+        accumulate(s.retired[static_cast<int>(it->role)], it->last);
+        s.threads.erase(it);
+        return;
+    }
+}
+
+int currentNode() {
+#ifdef __linux__
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return static_cast<int>(node);
+    }
+#endif
+    return 0;
+}
+
+SchedStats sample(Role role) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    SchedStats total = s.retired[static_cast<int>(role)];
+    for (auto& thread : s.threads) {
+        if (thread.role != role) continue;
+#ifdef __linux__
+        readThreadStats(thread.tid, thread.last);
+#endif
+        accumulate(total, thread.last);
+    }
+    return total;
+}
+
+} // namespace affinity
+} // namespace sim
@@ -0,0 +1,87 @@
+#include "Arena.h"
+#include "Memory.h"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+namespace sim {
+
+Arena::Arena(size_t initialBytes)
+    : blockSize(initialBytes)
+{
+}
+
+Arena::~Arena() {
+    release();
+    memory::freeLarge(block, blockSize);
+}
+
+Arena::Arena(Arena&& other) noexcept
+    : block(std::exchange(other.block, nullptr))
+    , blockSize(other.blockSize)
+    , offset(other.offset)
+    , stepBytes(other.stepBytes)
+    , peak(other.peak)
+    , spills(std::move(other.spills))
+{
+}
+
+Arena& Arena::operator=(Arena&& other) noexcept {
+    if (this != &other) {
+        release();
+        memory::freeLarge(block, blockSize);
+        block = std::exchange(other.block, nullptr);
+        blockSize = other.blockSize;
+        offset = other.offset;
+        stepBytes = other.stepBytes;
+        peak = other.peak;
+        spills = std::move(other.spills);
+    }
+    return *this;
+}
+
+void* Arena::allocateBytes(size_t bytes, size_t alignment) {
+    // The block is allocated by the first thread that uses the arena, which
+    // is the worker that owns it
+    if (!block) {
+        block = static_cast<char*>(memory::allocateLarge(blockSize));
+    }
+
+    const size_t start = (offset + alignment - 1) & ~(alignment - 1);
+    if (start + bytes <= blockSize) {
+        stepBytes += start + bytes - offset;
+        offset = start + bytes;
+        return block + start;
+    }
+
+    // Overflow for the rest of this step; folded into the block on reset()
+    const size_t spillBytes = bytes + alignment;
+    void* spill = memory::allocateLarge(spillBytes);
+    spills.push_back({spill, spillBytes});
+    stepBytes += spillBytes;
+
+    const auto address = reinterpret_cast<uintptr_t>(spill);
+    return reinterpret_cast<void*>((address + alignment - 1) & ~(uintptr_t(alignment) - 1));
+}
+
+void Arena::reset() {
+    peak = std::max(peak, stepBytes);
+    if (!spills.empty()) {
+        release();
+        memory::freeLarge(block, blockSize);
+        block = nullptr;
+        // Headroom so slow growth does not spill every step
+        blockSize = peak + peak / 2;
+    }
+    offset = 0;
+    stepBytes = 0;
+}
+
+void Arena::release() {
+    for (const auto& spill : spills) {
+        memory::freeLarge(spill.pointer, spill.bytes);
+    }
+    spills.clear();
+}
+
+} // namespace sim
@@ -0,0 +1,211 @@
+#include "AsyncScene.h"
+#include "Config.h"
+#include "Log.h"
+#include "Scene.h"
+#include "Trace.h"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+namespace sim {
+
+namespace {
+
+// FIFO of scene turns run by a fixed set of threads. The threads stay
+// unpinned: they serve scenes of every backend and would otherwise contend
+// with the physics thread or the CPU backend's workers for their CPUs.
+class Executor {
+public:
+    static Executor& shared() {
+        static Executor instance(config::Async::EXECUTOR_THREADS);
+        return instance;
+    }
+
+    void post(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    ~Executor() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads) thread.join();
+    }
+
+private:
+    explicit Executor(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            threads.emplace_back([this] { run(); });
+        }
+    }
+
+    void run() {
+        SIM_TRACE_THREAD("asyncExecutor");
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::function<void()>> tasks;  // guarded by mutex
+    bool stopping{false};                     // guarded by mutex
+    std::vector<std::thread> threads;
+};
+
+} // namespace
+
+AsyncScene::AsyncScene(const std::string& backendName, int numBalls, float screenWidth,
+                       float screenHeight, uint32_t seed)
+    : physics(createBackend(backendName))
+    , balls(generateBalls(numBalls, screenWidth, screenHeight, seed))
+    , name(physics->name())
+{
+    physics->initialize(balls.size(), static_cast<int>(screenWidth), static_cast<int>(screenHeight));
+    physics->setConstants(makeConstants(screenWidth, screenHeight));
+    snapshots.publish(balls, stepCount);
+    nextFuture = nextPromise.get_future().share();
+}
+
+AsyncScene::~AsyncScene() {
+    {
+        // A queued turn sees stopping and returns without stepping
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+        idle.wait(lock, [this] { return !scheduled; });
+    }
+    physics->cleanup();
+}
+
+std::future<uint64_t> AsyncScene::stepAsync(int steps) {
+    if (steps < 0) {
+        throw std::invalid_argument("stepAsync: steps must not be negative");
+    }
+    Request request;
+    request.remaining = steps;
+    std::future<uint64_t> done = request.done.get_future();
+    std::lock_guard<std::mutex> lock(mutex);
+    requests.push_back(std::move(request));
+    if (!scheduled) {
+        scheduled = true;
+        Executor::shared().post([this] { runBatch(); });
+    }
+    return done;
+}
+
+std::shared_future<Snapshot> AsyncScene::nextSnapshot() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (failure) {
+        // Nothing will be published again
+        std::promise<Snapshot> failed;
+        failed.set_exception(failure);
+        return failed.get_future().share();
+    }
+    snapshotWanted = true;
+    return nextFuture;
+}
+
+void AsyncScene::runBatch() {
+    int batch = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping || requests.empty()) {
+            scheduled = false;
+            idle.notify_all();
+            return;
+        }
+        batch = std::min(requests.front().remaining, config::Async::MAX_BATCH_STEPS);
+    }
+
+    std::exception_ptr error;
+    if (!failure && batch > 0) {
+        SIM_TRACE_SCOPE("asyncStep");
+        try {
+            if (batch == 1) {
+                physics->updatePhysics(balls);
+            } else {
+                physics->advance(balls, batch);
+            }
+            stepCount += static_cast<uint64_t>(batch);
+            publish();
+        } catch (const std::exception& e) {
+            SIM_LOG_ERROR << "Async step failed on " << name << ": " << e.what();
+            error = std::current_exception();
+        }
+    }
+
+    Request finished;
+    bool complete = false;
+    std::promise<Snapshot> abandoned;
+    bool abandonSnapshot = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (error) {
+            failure = error;
+            if (snapshotWanted) {
+                abandoned = std::move(nextPromise);
+                abandonSnapshot = true;
+                snapshotWanted = false;
+            }
+        }
+        Request& front = requests.front();
+        front.remaining -= batch;
+        if (failure || front.remaining <= 0) {
+            finished = std::move(front);
+            requests.pop_front();
+            complete = true;
+        }
+    }
+
+    // Futures are completed outside the lock; their continuations may
+    // call back into the scene
+    if (abandonSnapshot) abandoned.set_exception(failure);
+    if (complete) {
+        if (failure) {
+            finished.done.set_exception(failure);
+        } else {
+            finished.done.set_value(stepCount);
+        }
+    }
+
+    // Back of the queue, so a long request does not starve other scenes
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!stopping && !requests.empty()) {
+        Executor::shared().post([this] { runBatch(); });
+        return;
+    }
+    scheduled = false;
+    idle.notify_all();
+}
+
+void AsyncScene::publish() {
+    snapshots.publish(balls, stepCount);
+
+    std::promise<Snapshot> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!snapshotWanted) return;
+        ready = std::move(nextPromise);
+        nextPromise = std::promise<Snapshot>();
+        nextFuture = nextPromise.get_future().share();
+        snapshotWanted = false;
+    }
+    ready.set_value(Snapshot{balls, stepCount, trace::nowNs()});
+}
+
+} // namespace sim
@@ -0,0 +1,302 @@
+#include "Benchmark.h"
+#include "CPUKernels.h"
+#include "CPUPhysics.h"
+#include "Histogram.h"
+#include "PerfCounters.h"
+#include "Scene.h"
+#include "SnapshotBuffer.h"
+#include "Trace.h"
+#include "Log.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace sim {
+
+namespace {
+
+void writeLatency(std::ostream& out, const LatencyHistogram& histogram) {
+    const auto s = histogram.summary();
+    out << "\"count\": " << s.count
+        << ", \"mean_ms\": " << s.mean / 1e6
+        << ", \"p50_ms\": " << s.p50 / 1e6
+        << ", \"p99_ms\": " << s.p99 / 1e6
+        << ", \"p999_ms\": " << s.p999 / 1e6
+        << ", \"max_ms\": " << s.max / 1e6;
+}
+
+void writeCounters(std::ostream& out, perf::Phase phase) {
+    const perf::PhaseTotals totals = perf::totals(phase);
+    out << ", \"counters\": {";
+    for (int i = 0; i < perf::COUNTER_COUNT; ++i) {
+        out << "\"" << perf::counterName(static_cast<perf::Counter>(i)) << "\": "
+            << totals.values[i] << ", ";
+    }
+    out << "\"ipc\": " << totals.ipc() << ", \"scopes\": " << totals.scopes << "}";
+}
+
+std::ostream* openReport(const std::string& path, std::ofstream& file) {
+    if (path.empty()) return &std::cout;
+    file.open(path);
+    if (!file.is_open()) {
+        SIM_LOG_ERROR << "Failed to open benchmark output " << path;
+        return nullptr;
+    }
+    return &file;
+}
+
+// Times integration and all-pairs narrowphase for one layout. The scene is
+// the same for every layout and the kernels are bitwise identical, so the
+// contact checksum must match across layouts.
+template <typename Layout>
+void benchmarkLayout(std::ostream& out, const std::vector<Ball>& balls,
+                     const SimConstants& constants, int iterations, bool counters) {
+    using Store = BallStore<Layout>;
+    const size_t count = balls.size();
+
+    Store states;
+    memory::LargeVector<BallProperties> properties;
+    memory::LargeVector<float> radii;
+    states.reserve(count);
+    for (const Ball& ball : balls) {
+        states.push_back(stateOf(ball));
+        properties.push_back(propertiesOf(ball));
+        radii.push_back(ball.radius);
+    }
+    std::vector<BallState> resolved(count);
+
+    LatencyHistogram integrate, narrowphase;
+    uint64_t contacts = 0;
+    perf::resetTotals();
+
+    for (int i = 0; i < iterations; ++i) {
+        const uint64_t startNs = trace::nowNs();
+        {
+            perf::PhaseScope scope(perf::Phase::Integrate);
+            for (size_t first = 0; first < count; first += Store::CHUNK) {
+                kernels::integrateLanes<Store::STRIDE>(states.lanes(first), &properties[first],
+                                                       std::min(Store::CHUNK, count - first), constants);
+            }
+        }
+        const uint64_t integratedNs = trace::nowNs();
+        {
+            perf::PhaseScope scope(perf::Phase::Narrowphase);
+            for (size_t k = 0; k < count; ++k) {
+                BallState ball = states.load(k);
+                contacts += kernels::resolveCollisions(ball, properties[k], k, states, radii.data(),
+                                                       properties.data(), count, constants.restitution);
+                resolved[k] = ball;
+            }
+        }
+        integrate.record(integratedNs - startNs);
+        narrowphase.record(trace::nowNs() - integratedNs);
+
+        for (size_t k = 0; k < count; ++k) {
+            states.store(k, resolved[k]);
+        }
+    }
+
+    const double ballCount = static_cast<double>(count);
+    out << "    \"" << Layout::NAME << "\": {\n"
+        << "      \"contacts\": " << contacts << ",\n"
+        << "      \"integrate\": {";
+    writeLatency(out, integrate);
+    out << ", \"ns_per_ball\": " << integrate.sumNs() / (ballCount * iterations);
+    if (counters) writeCounters(out, perf::Phase::Integrate);
+    out << "},\n      \"narrowphase\": {";
+    writeLatency(out, narrowphase);
+    out << ", \"ns_per_pair\": " << narrowphase.sumNs() / (ballCount * ballCount * iterations);
+    if (counters) writeCounters(out, perf::Phase::Narrowphase);
+    out << "}\n    }";
+}
+
+// Reruns the backend once per prefetch distance on the same scene. Backends
+// without a grid narrowphase report the same figures for every entry.
+void sweepPrefetch(std::ostream& out, const BenchmarkOptions& options,
+                   const SimConstants& constants, float width, float height) {
+    const size_t saved = grid::prefetchDistance();
+    out << ",\n  \"prefetch_sweep\": [";
+    for (size_t i = 0; i < options.prefetchSweep.size(); ++i) {
+        const size_t distance = options.prefetchSweep[i];
+        grid::setPrefetchDistance(distance);
+
+        auto physics = createBackend(options.backendName);
+        physics->initialize(options.numBalls, static_cast<int>(width), static_cast<int>(height));
+        physics->setConstants(constants);
+        std::vector<Ball> balls = generateBalls(options.numBalls, width, height, options.seed);
+        for (int step = 0; step < options.warmupSteps; ++step) {
+            physics->updatePhysics(balls);
+        }
+
+        LatencyHistogram narrowphase;
+        const uint64_t startNs = trace::nowNs();
+        for (int step = 0; step < options.steps; ++step) {
+            physics->updatePhysics(balls);
+            narrowphase.record(physics->lastStepStats().narrowphaseNs);
+        }
+        const double wallSeconds = (trace::nowNs() - startNs) / 1e9;
+
+        out << (i ? ",\n" : "\n") << "    {\"distance\": " << distance
+            << ", \"steps_per_second\": " << options.steps / wallSeconds
+            << ", \"narrowphase\": {";
+        writeLatency(out, narrowphase);
+        out << "}}";
+    }
+    out << "\n  ]";
+    grid::setPrefetchDistance(saved);
+}
+
+} // namespace
+
+Benchmark::Benchmark(BenchmarkOptions options_)
+    : options(std::move(options_))
+{
+}
+
+bool Benchmark::run() {
+    const float width = static_cast<float>(config::Display::DEFAULT_WIDTH);
+    const float height = static_cast<float>(config::Display::DEFAULT_HEIGHT);
+    const SimConstants constants = makeConstants(width, height);
+
+    auto physics = createBackend(options.backendName);
+    physics->initialize(options.numBalls, static_cast<int>(width), static_cast<int>(height));
+    physics->setConstants(constants);
+
+    std::vector<Ball> balls = generateBalls(options.numBalls, width, height, options.seed);
+    SnapshotBuffer snapshots;
+
+    for (int i = 0; i < options.warmupSteps; ++i) {
+        physics->updatePhysics(balls);
+    }
+
+    LatencyHistogram step, integrate, broadphase, narrowphase, publish;
+    perf::resetTotals();
+    perf::setEnabled(options.perfCounters);
+
+    // Batches of more than one step go through advance(), so backends that
+    // keep steps on the device are measured that way; a batch records its
+    // mean step time
+    const int batch = std::max(1, options.batchSteps);
+    const uint64_t startNs = trace::nowNs();
+    for (int i = 0; i < options.steps; i += batch) {
+        const int count = std::min(batch, options.steps - i);
+        const uint64_t stepStart = trace::nowNs();
+        if (count == 1) {
+            physics->updatePhysics(balls);
+        } else {
+            physics->advance(balls, count);
+        }
+        const uint64_t stepEnd = trace::nowNs();
+        step.record((stepEnd - stepStart) / count);
+
+        const StepStats stats = physics->lastStepStats();
+        integrate.record(stats.integrateNs);
+        if (stats.broadphaseNs) broadphase.record(stats.broadphaseNs);
+        narrowphase.record(stats.narrowphaseNs);
+
+        {
+            perf::PhaseScope counters(perf::Phase::Publish);
+            snapshots.publish(balls, static_cast<uint64_t>(i + count));
+        }
+        publish.record(trace::nowNs() - stepEnd);
+    }
+    const double wallSeconds = (trace::nowNs() - startNs) / 1e9;
+    perf::setEnabled(false);
+
+    std::ofstream file;
+    std::ostream* report = openReport(options.outputPath, file);
+    if (!report) return false;
+    std::ostream& out = *report;
+
+    const bool counters = options.perfCounters && perf::available();
+    out << std::fixed << std::setprecision(6)
+        << "{\n"
+        << "  \"backend\": \"" << physics->name() << "\",\n"
+        << "  \"balls\": " << options.numBalls << ",\n"
+        << "  \"steps\": " << options.steps << ",\n"
+        << "  \"batch_steps\": " << batch << ",\n"
+        << "  \"seed\": " << options.seed << ",\n"
+        << "  \"prefetch_distance\": " << grid::prefetchDistance() << ",\n"
+        << "  \"wall_seconds\": " << wallSeconds << ",\n"
+        << "  \"steps_per_second\": " << options.steps / wallSeconds << ",\n"
+        << "  \"perf_counters\": " << (counters ? "true" : "false") << ",\n"
+        << "  \"phases\": {\n";
+
+    out << "    \"step\": {";
+    writeLatency(out, step);
+    out << "}";
+
+    const struct {
+        perf::Phase phase;
+        const LatencyHistogram& histogram;
+    } phases[] = {
+        {perf::Phase::Integrate, integrate},
+        {perf::Phase::Broadphase, broadphase},
+        {perf::Phase::Narrowphase, narrowphase},
+        {perf::Phase::Publish, publish},
+    };
+    for (const auto& entry : phases) {
+        out << ",\n    \"" << perf::phaseName(entry.phase) << "\": {";
+        writeLatency(out, entry.histogram);
+        if (counters) writeCounters(out, entry.phase);
+        out << "}";
+    }
+    out << "\n  }";
+    if (!options.prefetchSweep.empty()) {
+        sweepPrefetch(out, options, constants, width, height);
+    }
+    out << "\n}\n";
+
+    if (options.perfCounters && !perf::available()) {
+        SIM_LOG_WARN << "Hardware counters unavailable (check perf_event_paranoid)";
+    }
+    return out.good();
+}
+
+LayoutBenchmark::LayoutBenchmark(BenchmarkOptions options_)
+    : options(std::move(options_))
+{
+}
+
+bool LayoutBenchmark::run() {
+    const float width = static_cast<float>(config::Display::DEFAULT_WIDTH);
+    const float height = static_cast<float>(config::Display::DEFAULT_HEIGHT);
+    const SimConstants constants = makeConstants(width, height);
+    const std::vector<Ball> balls = generateBalls(options.numBalls, width, height, options.seed);
+
+    std::ofstream file;
+    std::ostream* report = openReport(options.outputPath, file);
+    if (!report) return false;
+    std::ostream& out = *report;
+
+    perf::setEnabled(options.perfCounters);
+    // Opens this thread's counters before the first measurement
+    { perf::PhaseScope probe(perf::Phase::Publish); }
+    const bool counters = options.perfCounters && perf::available();
+
+    out << std::fixed << std::setprecision(6)
+        << "{\n"
+        << "  \"benchmark\": \"layouts\",\n"
+        << "  \"balls\": " << options.numBalls << ",\n"
+        << "  \"iterations\": " << options.steps << ",\n"
+        << "  \"seed\": " << options.seed << ",\n"
+        << "  \"perf_counters\": " << (counters ? "true" : "false") << ",\n"
+        << "  \"layouts\": {\n";
+    benchmarkLayout<layout::Aos>(out, balls, constants, options.steps, counters);
+    out << ",\n";
+    benchmarkLayout<layout::Soa>(out, balls, constants, options.steps, counters);
+    out << ",\n";
+    benchmarkLayout<layout::Aosoa<8>>(out, balls, constants, options.steps, counters);
+    out << ",\n";
+    benchmarkLayout<layout::Aosoa<16>>(out, balls, constants, options.steps, counters);
+    out << "\n  }\n}\n";
+    perf::setEnabled(false);
+
+    if (options.perfCounters && !counters) {
+        SIM_LOG_WARN << "Hardware counters unavailable (check perf_event_paranoid)";
+    }
+    return out.good();
+}
+
+} // namespace sim
@@ -0,0 +1,151 @@
+#include "BouncingCore.h"
+#include "PhysicsBackend.h"
+#include "Scene.h"
+#include "Log.h"
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The ball vector is the state every backend writes back after a step, so
+// views point straight into it with the Ball stride
+struct bb_scene {
+    std::unique_ptr<sim::PhysicsBackend> physics;
+    std::vector<sim::Ball> balls;
+    sim::SimConstants constants{};
+    float width{0.0f};
+    float height{0.0f};
+    uint64_t steps{0};
+    std::string backendName;
+    std::string failure;  // set once a backend call throws
+};
+
+namespace {
+
+thread_local std::string lastError;
+
+bb_status fail(bb_status status, const std::string& message) {
+    lastError = message;
+    return status;
+}
+
+// Runs a backend call; a throwing backend may have left its device state
+// half updated, so the scene refuses further work
+template <typename Call>
+bb_status guarded(bb_scene* scene, Call&& call) {
+    if (!scene) return fail(BB_INVALID_ARGUMENT, "scene is null");
+    if (!scene->failure.empty()) return fail(BB_BACKEND_ERROR, "scene failed earlier: " + scene->failure);
+    try {
+        call();
+        return BB_OK;
+    } catch (const std::exception& error) {
+        scene->failure = error.what();
+        SIM_LOG_ERROR << "Scene on " << scene->backendName << " failed: " << error.what();
+        return fail(BB_BACKEND_ERROR, error.what());
+    }
+}
+
+void initializeBackend(bb_scene& scene) {
+    scene.physics->initialize(scene.balls.size(), static_cast<int>(scene.width),
+                              static_cast<int>(scene.height));
+    scene.physics->setConstants(scene.constants);
+}
+
+template <typename T>
+const T* field(const sim::Ball* first, size_t offset) {
+    if (!first) return nullptr;
+    return reinterpret_cast<const T*>(reinterpret_cast<const char*>(first) + offset);
+}
+
+} // namespace
+
+extern "C" {
+
+int bb_api_version(void) {
+    return BB_API_VERSION;
+}
+
+bb_scene* bb_scene_create(const char* backend, int balls, float width, float height,
+                          uint32_t seed) {
+    if (balls < 0 || !(width > 0.0f) || !(height > 0.0f)) {
+        fail(BB_INVALID_ARGUMENT, "ball count and screen size must be positive");
+        return nullptr;
+    }
+    try {
+        auto scene = std::make_unique<bb_scene>();
+        scene->physics = sim::createBackend(backend ? backend : sim::backend::CPU);
+        scene->backendName = scene->physics->name();
+        scene->width = width;
+        scene->height = height;
+        scene->constants = sim::makeConstants(width, height);
+        scene->balls = sim::generateBalls(balls, width, height, seed);
+        initializeBackend(*scene);
+        lastError.clear();
+        return scene.release();
+    } catch (const std::exception& error) {
+        fail(BB_BACKEND_ERROR, error.what());
+        return nullptr;
+    }
+}
+
+void bb_scene_destroy(bb_scene* scene) {
+    if (!scene) return;
+    try {
+        scene->physics->cleanup();
+    } catch (const std::exception& error) {
+        SIM_LOG_WARN << "Backend cleanup failed: " << error.what();
+    }
+    delete scene;
+}
+
+bb_status bb_scene_step(bb_scene* scene, int steps) {
+    if (steps < 0) return fail(BB_INVALID_ARGUMENT, "steps must not be negative");
+    return guarded(scene, [&] {
+        if (steps == 1) {
+            scene->physics->updatePhysics(scene->balls);
+        } else if (steps > 1) {
+            scene->physics->advance(scene->balls, steps);
+        }
+        scene->steps += static_cast<uint64_t>(steps);
+    });
+}
+
+bb_status bb_scene_spawn(bb_scene* scene, int count, uint32_t seed) {
+    if (count < 0) return fail(BB_INVALID_ARGUMENT, "count must not be negative");
+    return guarded(scene, [&] {
+        if (count == 0) return;
+        auto spawned = sim::generateBalls(count, scene->width, scene->height, seed);
+        scene->balls.insert(scene->balls.end(), spawned.begin(), spawned.end());
+        // Device buffers are sized for the ball count
+        scene->physics->cleanup();
+        initializeBackend(*scene);
+    });
+}
+
+bb_status bb_scene_view(const bb_scene* scene, bb_state_view* view) {
+    if (!scene || !view) return fail(BB_INVALID_ARGUMENT, "scene and view must not be null");
+
+    const sim::Ball* first = scene->balls.data();
+    view->count = scene->balls.size();
+    view->stride = sizeof(sim::Ball);
+    view->step = scene->steps;
+    view->position_x = field<float>(first, offsetof(sim::Ball, position) + offsetof(sim::Vec2, x));
+    view->position_y = field<float>(first, offsetof(sim::Ball, position) + offsetof(sim::Vec2, y));
+    view->velocity_x = field<float>(first, offsetof(sim::Ball, velocity) + offsetof(sim::Vec2, x));
+    view->velocity_y = field<float>(first, offsetof(sim::Ball, velocity) + offsetof(sim::Vec2, y));
+    view->radius = field<float>(first, offsetof(sim::Ball, radius));
+    view->mass = field<float>(first, offsetof(sim::Ball, mass));
+    view->color = field<uint32_t>(first, offsetof(sim::Ball, color));
+    return BB_OK;
+}
+
+const char* bb_scene_backend(const bb_scene* scene) {
+    return scene ? scene->backendName.c_str() : "";
+}
+
+const char* bb_last_error(void) {
+    return lastError.c_str();
+}
+
+} // extern "C"
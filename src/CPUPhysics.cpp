@@ -0,0 +1,425 @@
+#include "CPUPhysics.h"
+#include "Trace.h"
+#include "PerfCounters.h"
+#include "Log.h"
+#include "Affinity.h"
+#include "CPUKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+
+namespace sim {
+
+namespace grid {
+
+namespace {
+std::atomic<size_t> distance{config::Grid::PREFETCH_DISTANCE};
+}
+
+void setPrefetchDistance(size_t balls) {
+    distance.store(balls, std::memory_order_relaxed);
+}
+
+size_t prefetchDistance() {
+    return distance.load(std::memory_order_relaxed);
+}
+
+} // namespace grid
+
+template <typename Layout>
+BasicCPUPhysics<Layout>::BasicCPUPhysics(size_t numThreads)
+    : requestedThreads(numThreads)
+{
+}
+
+template <typename Layout>
+BasicCPUPhysics<Layout>::~BasicCPUPhysics() {
+    if (initialized) {
+        cleanup();
+    }
+}
+
+template <typename Layout>
+void BasicCPUPhysics<Layout>::cleanup() {
+    workers.reset();
+    partitions.clear();
+    stripOwner.clear();
+    snapshots.clear();
+    current.clear();
+    properties.clear();
+    grid = Grid{};
+    workerCounters.clear();
+    scattered = false;
+    initialized = false;
+}
+
+template <typename Layout>
+void BasicCPUPhysics<Layout>::initialize(size_t numBalls_, int /*screenWidth*/, int /*screenHeight*/) {
+    if (initialized) return;
+
+    numBalls = numBalls_;
+    size_t threads = requestedThreads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    workers = std::make_unique<WorkerPool>(threads);
+    partitions.resize(workers->size());
+    workerCounters.assign(workers->size(), WorkerCounters{});
+    current.resize(numBalls);
+    properties.resize(numBalls);
+    grid.cellOf.resize(numBalls);
+    grid.order.resize(numBalls);
+    assignStrips();
+
+    SIM_LOG_INFO << "Initializing CPU physics with " << numBalls << " balls on "
+                 << workers->size() << " worker(s), " << snapshots.size() << " NUMA node(s)";
+
+    initialized = true;
+}
+
+template <typename Layout>
+void BasicCPUPhysics<Layout>::assignStrips() {
+    const size_t count = partitions.size();
+
+    // Ask every worker where it runs; pinned workers stay there
+    std::vector<int> nodes(count, 0);
+    workers->parallelFor(count, [&](size_t begin, size_t end, size_t /*worker*/) {
+        for (size_t p = begin; p < end; ++p) {
+            nodes[p] = affinity::currentNode();
+        }
+    });
+
+    // Adjacent strips go to workers on the same node, so most migrations and
+    // neighbour reads stay node-local
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return nodes[a] < nodes[b]; });
+
+    stripOwner = order;
+    std::vector<int> replicaNodes;
+    for (size_t strip = 0; strip < count; ++strip) {
+        Partition& partition = partitions[order[strip]];
+        partition.strip = strip;
+        if (replicaNodes.empty() || replicaNodes.back() != nodes[order[strip]]) {
+            replicaNodes.push_back(nodes[order[strip]]);
+        }
+        partition.replica = replicaNodes.size() - 1;
+    }
+
+    // First touch of each snapshot replica by a worker on its node
+    snapshots.assign(replicaNodes.size(), {});
+    std::vector<bool> touched(replicaNodes.size(), false);
+    std::vector<bool> firstOnNode(count, false);
+    for (size_t strip = 0; strip < count; ++strip) {
+        const size_t p = order[strip];
+        if (!touched[partitions[p].replica]) {
+            touched[partitions[p].replica] = true;
+            firstOnNode[p] = true;
+        }
+    }
+    workers->parallelFor(count, [&](size_t begin, size_t end, size_t /*worker*/) {
+        for (size_t p = begin; p < end; ++p) {
+            if (firstOnNode[p]) {
+                Snapshot& snapshot = snapshots[partitions[p].replica];
+                snapshot.states.resize(numBalls);
+                snapshot.radii.resize(numBalls);
+                snapshot.properties.resize(numBalls);
+                snapshot.ids.resize(numBalls);
+            }
+        }
+    });
+}
+
+template <typename Layout>
+size_t BasicCPUPhysics<Layout>::partitionAt(float x) const {
+    const float strip = stripWidth > 0.0f ? x / stripWidth : 0.0f;
+    const size_t last = stripOwner.size() - 1;
+    const size_t index = strip <= 0.0f ? 0 : std::min(static_cast<size_t>(strip), last);
+    return stripOwner[index];
+}
+
+template <typename Layout>
+uint32_t BasicCPUPhysics<Layout>::cellAt(const Vec2& position) const {
+    // Integration clamps balls to the screen; clamp again for NaN safety
+    const float fx = position.x / grid.cellSize;
+    const float fy = position.y / grid.cellSize;
+    const size_t cx = fx > 0.0f ? std::min(static_cast<size_t>(fx), grid.columns - 1) : 0;
+    const size_t cy = fy > 0.0f ? std::min(static_cast<size_t>(fy), grid.rows - 1) : 0;
+    return static_cast<uint32_t>(cy * grid.columns + cx);
+}
+
+template <typename Layout>
+void BasicCPUPhysics<Layout>::scatter(const std::vector<Ball>& balls, size_t p) {
+    // Runs on the owning worker, so the partition's pages are allocated on
+    // its node. Room for twice the fair share before the first regrowth.
+    Partition& partition = partitions[p];
+    const size_t fairShare = numBalls / partitions.size() + 1;
+    partition.states.clear();
+    partition.properties.clear();
+    partition.ids.clear();
+    partition.states.reserve(2 * fairShare);
+    partition.properties.reserve(2 * fairShare);
+    partition.ids.reserve(2 * fairShare);
+
+    for (size_t i = 0; i < numBalls; ++i) {
+        if (partitionAt(balls[i].position.x) == p) {
+            partition.states.push_back(stateOf(balls[i]));
+            partition.properties.push_back(propertiesOf(balls[i]));
+            partition.ids.push_back(static_cast<uint32_t>(i));
+            properties[i] = partition.properties.back();
+        }
+    }
+}
+
+template <typename Layout>
+void BasicCPUPhysics<Layout>::sortCells() {
+    // Counting sort by cell; ids ascend within each cell
+    const size_t cells = grid.columns * grid.rows;
+    uint32_t* start = grid.cellStart.data();
+    std::fill(start, start + cells + 1, 0u);
+    for (size_t id = 0; id < numBalls; ++id) {
+        ++start[grid.cellOf[id]];
+    }
+    uint32_t sum = 0;
+    for (size_t c = 0; c <= cells; ++c) {
+        const uint32_t n = start[c];
+        start[c] = sum;
+        sum += n;
+    }
+    // Each cursor ends at the start of the next cell; shift back afterwards
+    for (size_t id = 0; id < numBalls; ++id) {
+        grid.order[start[grid.cellOf[id]]++] = static_cast<uint32_t>(id);
+    }
+    for (size_t c = cells; c > 0; --c) {
+        start[c] = start[c - 1];
+    }
+    start[0] = 0;
+}
+
+template <typename Layout>
+void BasicCPUPhysics<Layout>::migrateIn(size_t p) {
+    // Sources are visited in partition order, so the layout is deterministic
+    Partition& partition = partitions[p];
+    for (const Partition& source : partitions) {
+        for (size_t k = 0; k < source.outCount; ++k) {
+            if (source.outTargets[k] == p) {
+                partition.states.push_back(source.outStates[k]);
+                partition.properties.push_back(source.outProperties[k]);
+                partition.ids.push_back(source.outIds[k]);
+            }
+        }
+    }
+}
+
+template <typename Layout>
+std::string BasicCPUPhysics<Layout>::name() const {
+    if (std::is_same_v<Layout, layout::Aos>) {
+        return requestedThreads == 1 ? backend::CPU_SERIAL : backend::CPU;
+    }
+    return std::string("cpu-") + Layout::NAME;
+}
+
+template <typename Layout>
+void BasicCPUPhysics<Layout>::updatePhysics(std::vector<Ball>& balls) {
+    using Store = BallStore<Layout>;
+    const uint64_t startNs = trace::nowNs();
+    const size_t count = partitions.size();
+
+    // Partition i maps to worker i since count == workers->size()
+    if (!scattered) {
+        stripWidth = constants.screenDimensions.x / static_cast<float>(count);
+
+        // Touching balls are at most two of the largest radii apart, so
+        // they always share a cell or sit in adjacent ones
+        float maxRadius = 0.0f;
+        for (size_t i = 0; i < numBalls; ++i) {
+            maxRadius = std::max(maxRadius, balls[i].radius);
+        }
+        grid.cellSize = std::max(2.0f * maxRadius, 1.0f);
+        grid.columns = std::max<size_t>(1, static_cast<size_t>(std::ceil(constants.screenDimensions.x / grid.cellSize)));
+        grid.rows = std::max<size_t>(1, static_cast<size_t>(std::ceil(constants.screenDimensions.y / grid.cellSize)));
+        grid.cellStart.resize(grid.columns * grid.rows + 1);
+
+        workers->parallelFor(count, [&](size_t begin, size_t end, size_t /*worker*/) {
+            for (size_t p = begin; p < end; ++p) scatter(balls, p);
+        });
+        scattered = true;
+    }
+
+    // Integration and boundary response (updateBallPhysics)
+    workers->parallelFor(count, [&](size_t begin, size_t end, size_t /*worker*/) {
+        SIM_TRACE_SCOPE("integrate");
+        perf::PhaseScope counters(perf::Phase::Integrate);
+        for (size_t p = begin; p < end; ++p) {
+            Partition& partition = partitions[p];
+            partition.scratch.reset();
+            const size_t size = partition.states.size();
+            for (size_t first = 0; first < size; first += Store::CHUNK) {
+                kernels::integrateLanes<Store::STRIDE>(partition.states.lanes(first),
+                                                       &partition.properties[first],
+                                                       std::min(Store::CHUNK, size - first), constants);
+            }
+            for (size_t k = 0; k < size; ++k) {
+                const BallState ball = partition.states.load(k);
+                current[partition.ids[k]] = ball;
+                grid.cellOf[partition.ids[k]] = cellAt(ball.position);
+            }
+        }
+    });
+    const uint64_t integratedNs = trace::nowNs();
+
+    // Bin into the grid and write every snapshot replica in cell order;
+    // each worker copies an equal share of the slots
+    {
+        SIM_TRACE_SCOPE("broadphase");
+        perf::PhaseScope counters(perf::Phase::Broadphase);
+        sortCells();
+    }
+    workers->parallelFor(count, [&](size_t begin, size_t end, size_t /*worker*/) {
+        SIM_TRACE_SCOPE("broadphase");
+        perf::PhaseScope counters(perf::Phase::Broadphase);
+        const size_t first = begin * numBalls / count;
+        const size_t last = end * numBalls / count;
+        for (auto& snapshot : snapshots) {
+            for (size_t slot = first; slot < last; ++slot) {
+                const uint32_t id = grid.order[slot];
+                snapshot.states.store(slot, current[id]);
+                snapshot.radii[slot] = properties[id].radius;
+                snapshot.properties[slot] = properties[id];
+                snapshot.ids[slot] = id;
+            }
+        }
+    });
+    const uint64_t broadphaseNs = trace::nowNs();
+
+    // Slot ranges of the up to three rows of cells around `cell`
+    const auto neighbourRows = [&](uint32_t cell, auto&& visit) {
+        const size_t cx = cell % grid.columns;
+        const size_t cy = cell / grid.columns;
+        const size_t left = cx > 0 ? cx - 1 : 0;
+        const size_t right = std::min(cx + 1, grid.columns - 1);
+        const size_t bottom = std::min(cy + 1, grid.rows - 1);
+        for (size_t row = cy > 0 ? cy - 1 : 0; row <= bottom; ++row) {
+            visit(grid.cellStart[row * grid.columns + left],
+                  grid.cellStart[row * grid.columns + right + 1]);
+        }
+    };
+
+    // Ball-ball response against the integrated snapshot (detectCollisions)
+    const size_t distance = grid::prefetchDistance();
+    workers->parallelFor(count, [&](size_t begin, size_t end, size_t worker) {
+        SIM_TRACE_SCOPE("narrowphase");
+        perf::PhaseScope counters(perf::Phase::Narrowphase);
+        uint32_t contacts = 0;
+        for (size_t p = begin; p < end; ++p) {
+            Partition& partition = partitions[p];
+            const Snapshot& snapshot = snapshots[partition.replica];
+            const float* radii = snapshot.radii.data();
+            const size_t size = partition.states.size();
+
+            // Visit local balls cell by cell so consecutive balls share
+            // neighbour cells; the key packs (cell, local index)
+            Arena& scratch = partition.scratch;
+            uint64_t* byCell = scratch.allocate<uint64_t>(size);
+            for (size_t k = 0; k < size; ++k) {
+                byCell[k] = (uint64_t(grid.cellOf[partition.ids[k]]) << 32) | k;
+            }
+            std::sort(byCell, byCell + size);
+
+            for (size_t t = 0; t < size; ++t) {
+                // Neighbours of the ball `distance` ahead, once per cell
+                if (distance && t + distance < size) {
+                    const uint32_t ahead = static_cast<uint32_t>(byCell[t + distance] >> 32);
+                    if (ahead != static_cast<uint32_t>(byCell[t + distance - 1] >> 32)) {
+                        neighbourRows(ahead, [&](size_t from, size_t to) {
+                            kernels::prefetchSlots(snapshot.states, radii, from, to);
+                        });
+                    }
+                }
+
+                const size_t k = static_cast<uint32_t>(byCell[t]);
+                const uint32_t id = partition.ids[k];
+                const BallProperties& ballProperties = partition.properties[k];
+                BallState ball = partition.states.load(k);
+
+                partition.hits.clear();
+                neighbourRows(static_cast<uint32_t>(byCell[t] >> 32), [&](size_t from, size_t to) {
+                    kernels::collectHits(ball, ballProperties.radius, snapshot.states, radii,
+                                         snapshot.ids.data(), from, to, partition.hits);
+                });
+                std::sort(partition.hits.begin(), partition.hits.end(),
+                          [](const kernels::Hit& a, const kernels::Hit& b) { return a.id < b.id; });
+                contacts += kernels::resolveHits(ball, ballProperties, id, snapshot.states,
+                                                 snapshot.properties.data(), partition.hits.data(),
+                                                 partition.hits.size(), constants.restitution);
+                partition.states.store(k, ball);
+                storeState(balls[id], ball);
+            }
+        }
+        workerCounters[worker].contacts = contacts;
+    });
+    const uint64_t narrowphaseNs = trace::nowNs();
+
+    // Hand balls that left their strip to the new owner
+    workers->parallelFor(count, [&](size_t begin, size_t end, size_t worker) {
+        SIM_TRACE_SCOPE("migrateOut");
+        for (size_t p = begin; p < end; ++p) {
+            Partition& partition = partitions[p];
+            const size_t size = partition.states.size();
+            Arena& scratch = partition.scratch;
+            partition.outStates = scratch.allocate<BallState>(size);
+            partition.outProperties = scratch.allocate<BallProperties>(size);
+            partition.outIds = scratch.allocate<uint32_t>(size);
+            partition.outTargets = scratch.allocate<uint32_t>(size);
+            partition.outCount = 0;
+
+            size_t kept = 0;
+            for (size_t k = 0; k < size; ++k) {
+                const BallState ball = partition.states.load(k);
+                const size_t target = partitionAt(ball.position.x);
+                if (target == p) {
+                    partition.states.store(kept, ball);
+                    partition.properties[kept] = partition.properties[k];
+                    partition.ids[kept] = partition.ids[k];
+                    ++kept;
+                } else {
+                    const size_t out = partition.outCount++;
+                    partition.outStates[out] = ball;
+                    partition.outProperties[out] = partition.properties[k];
+                    partition.outIds[out] = partition.ids[k];
+                    partition.outTargets[out] = static_cast<uint32_t>(target);
+                }
+            }
+            partition.states.resize(kept);
+            partition.properties.resize(kept);
+            partition.ids.resize(kept);
+            workerCounters[worker].migrations = static_cast<uint32_t>(partition.outCount);
+        }
+    });
+    workers->parallelFor(count, [&](size_t begin, size_t end, size_t /*worker*/) {
+        SIM_TRACE_SCOPE("migrateIn");
+        for (size_t p = begin; p < end; ++p) migrateIn(p);
+    });
+
+    stepStats.integrateNs = integratedNs - startNs;
+    stepStats.broadphaseNs = broadphaseNs - integratedNs;
+    stepStats.narrowphaseNs = narrowphaseNs - broadphaseNs;
+    stepStats.contacts = 0;
+    stepStats.migrations = 0;
+    for (auto& counters : workerCounters) {
+        stepStats.contacts += counters.contacts;
+        stepStats.migrations += counters.migrations;
+        counters = WorkerCounters{};
+    }
+}
+
+template class BasicCPUPhysics<layout::Aos>;
+template class BasicCPUPhysics<layout::Soa>;
+template class BasicCPUPhysics<layout::Aosoa<8>>;
+template class BasicCPUPhysics<layout::Aosoa<16>>;
+
+} // namespace sim
@@ -0,0 +1,140 @@
+#include "DiffHarness.h"
+#include "Scene.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace sim {
+
+Tolerance toleranceFor(const std::string& backendName) {
+    if (backendName == backend::OPENCL_FAST) {
+        return {config::Validation::OPENCL_FAST_POSITION_TOLERANCE,
+                config::Validation::OPENCL_FAST_ENERGY_TOLERANCE};
+    }
+    // The persistent kernel is built with precise math too
+    if (backendName == backend::OPENCL || backendName == backend::OPENCL_PERSISTENT) {
+        return {config::Validation::OPENCL_POSITION_TOLERANCE,
+                config::Validation::OPENCL_ENERGY_TOLERANCE};
+    }
+    return {config::Validation::CPU_POSITION_TOLERANCE,
+            config::Validation::CPU_ENERGY_TOLERANCE};
+}
+
+StepDivergence compareStates(const std::vector<Ball>& reference,
+                             const std::vector<Ball>& candidate, const SimConstants& constants) {
+    StepDivergence divergence;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        const Ball& a = reference[i];
+        const Ball& b = candidate[i];
+        const float dp = std::hypot(a.position.x - b.position.x, a.position.y - b.position.y);
+        const float dv = std::hypot(a.velocity.x - b.velocity.x, a.velocity.y - b.velocity.y);
+        divergence.maxPositionError = std::max(divergence.maxPositionError, dp);
+        divergence.maxVelocityError = std::max(divergence.maxVelocityError, dv);
+    }
+    divergence.referenceEnergy = totalEnergy(reference, constants);
+    divergence.candidateEnergy = totalEnergy(candidate, constants);
+    divergence.energyDifference = std::fabs(divergence.referenceEnergy - divergence.candidateEnergy);
+    divergence.bitwiseEqual = reference.size() == candidate.size() &&
+                              std::memcmp(reference.data(), candidate.data(),
+                                          sizeof(Ball) * reference.size()) == 0;
+    return divergence;
+}
+
+DifferentialHarness::DifferentialHarness(DiffOptions options_)
+    : options(std::move(options_))
+{
+}
+
+DiffReport DifferentialHarness::run() {
+    DiffReport report;
+    report.referenceBackend = options.referenceBackend;
+    report.candidateBackend = options.candidateBackend;
+    report.deterministic = options.deterministic;
+
+    // The looser of the two backends decides how much drift is acceptable
+    const Tolerance refTol = toleranceFor(options.referenceBackend);
+    const Tolerance candTol = toleranceFor(options.candidateBackend);
+    report.tolerance.position = std::max(refTol.position, candTol.position);
+    report.tolerance.relativeEnergy = std::max(refTol.relativeEnergy, candTol.relativeEnergy);
+
+    const SimConstants constants = makeConstants(options.screenWidth, options.screenHeight);
+    const int width = static_cast<int>(options.screenWidth);
+    const int height = static_cast<int>(options.screenHeight);
+
+    auto reference = createBackend(options.referenceBackend);
+    auto candidate = createBackend(options.candidateBackend);
+    reference->initialize(options.numBalls, width, height);
+    reference->setConstants(constants);
+    candidate->initialize(options.numBalls, width, height);
+    candidate->setConstants(constants);
+
+    std::vector<Ball> refBalls = generateBalls(options.numBalls, options.screenWidth,
+                                               options.screenHeight, options.seed);
+    std::vector<Ball> candBalls = refBalls;
+
+    report.steps.reserve(options.steps);
+    for (int step = 1; step <= options.steps; ++step) {
+        reference->updatePhysics(refBalls);
+        candidate->updatePhysics(candBalls);
+
+        StepDivergence divergence = compareStates(refBalls, candBalls, constants);
+        divergence.step = step;
+
+        report.steps.push_back(divergence);
+
+        const double energyScale = std::max(std::fabs(divergence.referenceEnergy), 1.0);
+        report.maxPositionError = std::max(report.maxPositionError, divergence.maxPositionError);
+        report.maxVelocityError = std::max(report.maxVelocityError, divergence.maxVelocityError);
+        report.maxRelativeEnergyError = std::max(report.maxRelativeEnergyError,
+                                                 divergence.energyDifference / energyScale);
+
+        if (report.firstFailingStep < 0 && exceedsTolerance(divergence, report.tolerance)) {
+            report.firstFailingStep = step;
+        }
+    }
+
+    return report;
+}
+
+bool DifferentialHarness::exceedsTolerance(const StepDivergence& divergence,
+                                           const Tolerance& tolerance) const {
+    if (options.deterministic) {
+        return !divergence.bitwiseEqual;
+    }
+    const double energyScale = std::max(std::fabs(divergence.referenceEnergy), 1.0);
+    return divergence.maxPositionError > tolerance.position ||
+           divergence.energyDifference / energyScale > tolerance.relativeEnergy;
+}
+
+void DiffReport::print(std::ostream& out) const {
+    out << "Differential test: " << referenceBackend << " (reference) vs "
+        << candidateBackend << (deterministic ? " [bitwise]" : "") << "\n"
+        << "  tolerance: position " << tolerance.position
+        << " px, relative energy " << tolerance.relativeEnergy << "\n";
+
+    // Print a bounded number of rows plus every step that broke tolerance
+    const size_t stride = std::max<size_t>(1, steps.size() / 20);
+    out << std::setw(8) << "step" << std::setw(14) << "max dpos"
+        << std::setw(14) << "max dvel" << std::setw(16) << "energy diff"
+        << std::setw(10) << "bitwise" << "\n";
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const auto& s = steps[i];
+        if (i % stride != 0 && s.step != firstFailingStep && i + 1 != steps.size()) continue;
+        out << std::setw(8) << s.step << std::setw(14) << s.maxPositionError
+            << std::setw(14) << s.maxVelocityError << std::setw(16) << s.energyDifference
+            << std::setw(10) << (s.bitwiseEqual ? "yes" : "no") << "\n";
+    }
+
+    out << "  max error: position " << maxPositionError << " px, velocity "
+        << maxVelocityError << " px/s, relative energy " << maxRelativeEnergyError << "\n";
+
+    if (passed()) {
+        out << "PASSED (" << steps.size() << " steps)\n";
+    } else {
+        out << "FAILED at step " << firstFailingStep << "\n";
+    }
+}
+
+} // namespace sim
@@ -0,0 +1,392 @@
+#include "Distributed.h"
+#include "DiffHarness.h"
+#include "Log.h"
+#include "Scene.h"
+#include "Trace.h"
+#include "Wire.h"
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+extern char** environ;
+
+namespace sim {
+
+namespace {
+
+void putEntries(wire::Writer& out, const std::vector<const void*>& entries, size_t size) {
+    out.put(static_cast<uint32_t>(entries.size()));
+    for (const void* entry : entries) out.putBytes(entry, size);
+}
+
+template <typename Entry>
+void getEntries(wire::Reader& in, std::vector<Entry>& into) {
+    const uint32_t count = in.get<uint32_t>();
+    for (uint32_t i = 0; i < count; ++i) {
+        Entry entry;
+        std::memcpy(&entry, in.getBytes(sizeof(Entry)), sizeof(Entry));
+        into.push_back(entry);
+    }
+}
+
+} // namespace
+
+SlabRank::SlabRank(Transport& transport_, const DistributedOptions& options_)
+    : transport(transport_)
+    , options(options_)
+    , constants(makeConstants(options_.screenWidth, options_.screenHeight))
+{
+    const int rank = transport.rank();
+    slabWidth = options.screenWidth / transport.size();
+    slabLeft = slabWidth * rank;
+    slabRight = slabWidth * (rank + 1);
+    // Only neighbours may share contacts or trade balls
+    if (slabWidth < 2.0f * config::Distributed::HALO) {
+        throw std::invalid_argument("Too many ranks: slabs would be narrower than two halos");
+    }
+
+    // Every rank draws the same scene and keeps its slab, so ids are the
+    // indices of a single-process run with the same seed
+    const std::vector<Ball> scene = generateBalls(options.numBalls, options.screenWidth,
+                                                  options.screenHeight, options.seed);
+    for (size_t i = 0; i < scene.size(); ++i) {
+        if (ownerOf(scene[i].position.x) == rank) {
+            owned.push_back({static_cast<uint32_t>(i), scene[i]});
+        }
+    }
+
+    const float span = slabWidth + 2.0f * config::Distributed::HALO;
+    grid.originX = slabLeft - config::Distributed::HALO;
+    grid.columns = static_cast<int>(std::ceil(span / config::Distributed::HALO));
+    grid.rows = std::max(1, static_cast<int>(std::ceil(options.screenHeight / config::Distributed::HALO)));
+}
+
+int SlabRank::ownerOf(float x) const {
+    const int slab = static_cast<int>(std::floor(x / slabWidth));
+    return std::min(std::max(slab, 0), transport.size() - 1);
+}
+
+void SlabRank::integrate() {
+    for (Entry& entry : owned) {
+        BallState state = stateOf(entry.ball);
+        const BallProperties props = propertiesOf(entry.ball);
+        const BallLanes<float> lanes{&state.position.x, &state.position.y,
+                                     &state.velocity.x, &state.velocity.y};
+        kernels::integrateLanes<1>(lanes, &props, 1, constants);
+        storeState(entry.ball, state);
+    }
+}
+
+void SlabRank::exchangeHalo() {
+    const int rank = transport.rank();
+    std::vector<int> peers;
+    if (rank > 0) peers.push_back(rank - 1);
+    if (rank + 1 < transport.size()) peers.push_back(rank + 1);
+
+    // Emigrants stay here as ghosts for this step: the neighbour's halo
+    // message was packed before they arrived there
+    ghosts.clear();
+    std::vector<std::vector<const void*>> migrants(peers.size()), halo(peers.size());
+    std::vector<Entry> staying;
+    staying.reserve(owned.size());
+    ghosts.reserve(owned.size());
+    for (const Entry& entry : owned) {
+        const int owner = ownerOf(entry.ball.position.x);
+        if (owner == rank) {
+            staying.push_back(entry);
+            continue;
+        }
+        if (owner != rank - 1 && owner != rank + 1) {
+            throw std::runtime_error("Ball " + std::to_string(entry.id) + " crossed more than one slab");
+        }
+        ghosts.push_back(entry);
+        migrants[owner == rank - 1 ? 0 : peers.size() - 1].push_back(&ghosts.back());
+    }
+    owned.swap(staying);
+    for (const Entry& entry : owned) {
+        const float x = entry.ball.position.x;
+        if (rank > 0 && x < slabLeft + config::Distributed::HALO) halo[0].push_back(&entry);
+        if (rank + 1 < transport.size() && x >= slabRight - config::Distributed::HALO) {
+            halo[peers.size() - 1].push_back(&entry);
+        }
+    }
+
+    std::vector<std::string> outgoing(peers.size());
+    for (size_t i = 0; i < peers.size(); ++i) {
+        wire::Writer out;
+        putEntries(out, migrants[i], sizeof(Entry));
+        putEntries(out, halo[i], sizeof(Entry));
+        outgoing[i] = std::move(out.finish());
+        // The transport frames the message itself
+        outgoing[i].erase(0, wire::FRAME_HEADER_BYTES);
+    }
+
+    const std::vector<std::string> incoming = transport.exchange(peers, outgoing);
+    for (const std::string& message : incoming) {
+        wire::Reader in(message.data(), message.size());
+        const size_t before = owned.size();
+        getEntries(in, owned);
+        stats.migrations += owned.size() - before;
+        getEntries(in, ghosts);
+    }
+    stats.ghosts += ghosts.size();
+}
+
+void SlabRank::collide() {
+    // Owned and ghost balls in id order, then counting-sorted by cell; the
+    // sort is stable, so ids ascend within every cell
+    std::vector<const Entry*> local;
+    local.reserve(owned.size() + ghosts.size());
+    for (const Entry& entry : owned) local.push_back(&entry);
+    for (const Entry& entry : ghosts) local.push_back(&entry);
+    std::sort(local.begin(), local.end(),
+              [](const Entry* a, const Entry* b) { return a->id < b->id; });
+
+    const size_t count = local.size();
+    const size_t cells = static_cast<size_t>(grid.columns) * grid.rows;
+    auto cellAt = [&](const Vec2& position) {
+        const int column = std::min(std::max(static_cast<int>(
+            (position.x - grid.originX) / config::Distributed::HALO), 0), grid.columns - 1);
+        const int row = std::min(std::max(static_cast<int>(
+            position.y / config::Distributed::HALO), 0), grid.rows - 1);
+        return static_cast<uint32_t>(row * grid.columns + column);
+    };
+
+    grid.cellOf.resize(count);
+    grid.cellStart.assign(cells + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        grid.cellOf[i] = cellAt(local[i]->ball.position);
+        ++grid.cellStart[grid.cellOf[i] + 1];
+    }
+    for (size_t c = 0; c < cells; ++c) grid.cellStart[c + 1] += grid.cellStart[c];
+
+    snapshot.resize(count);
+    radii.resize(count);
+    properties.resize(count);
+    ids.resize(count);
+    std::vector<uint32_t> fill(grid.cellStart.begin(), grid.cellStart.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        const uint32_t slot = fill[grid.cellOf[i]]++;
+        snapshot.store(slot, stateOf(local[i]->ball));
+        radii[slot] = local[i]->ball.radius;
+        properties[slot] = propertiesOf(local[i]->ball);
+        ids[slot] = local[i]->id;
+    }
+
+    for (Entry& entry : owned) {
+        BallState state = stateOf(entry.ball);
+        const BallProperties props = propertiesOf(entry.ball);
+        const uint32_t cell = cellAt(state.position);
+        const int column = static_cast<int>(cell % grid.columns);
+        const int row = static_cast<int>(cell / grid.columns);
+
+        hits.clear();
+        for (int r = std::max(row - 1, 0); r <= std::min(row + 1, grid.rows - 1); ++r) {
+            const size_t first = static_cast<size_t>(r) * grid.columns + std::max(column - 1, 0);
+            const size_t last = static_cast<size_t>(r) * grid.columns + std::min(column + 1, grid.columns - 1);
+            kernels::collectHits(state, props.radius, snapshot, radii.data(), ids.data(),
+                                 grid.cellStart[first], grid.cellStart[last + 1], hits);
+        }
+        std::sort(hits.begin(), hits.end(),
+                  [](const kernels::Hit& a, const kernels::Hit& b) { return a.id < b.id; });
+        stats.contacts += kernels::resolveHits(state, props, entry.id, snapshot, properties.data(),
+                                               hits.data(), hits.size(), constants.restitution);
+        storeState(entry.ball, state);
+    }
+}
+
+bool SlabRank::run(std::ostream& report) {
+    for (int step = 0; step < options.steps; ++step) {
+        SIM_TRACE_SCOPE("rankStep");
+        const uint64_t startNs = trace::nowNs();
+        integrate();
+        const uint64_t integratedNs = trace::nowNs();
+        exchangeHalo();
+        const uint64_t exchangedNs = trace::nowNs();
+        collide();
+        const uint64_t doneNs = trace::nowNs();
+
+        stats.computeNs += (integratedNs - startNs) + (doneNs - exchangedNs);
+        stats.commNs += exchangedNs - integratedNs;
+    }
+    stats.balls = static_cast<uint32_t>(owned.size());
+    return gather(report);
+}
+
+// Every rank sends its stats and final balls to rank 0, which reports
+bool SlabRank::gather(std::ostream& report) {
+    const int rank = transport.rank();
+    const int size = transport.size();
+
+    if (rank != 0) {
+        wire::Writer out;
+        out.putBytes(&stats, sizeof(stats));
+        std::vector<const void*> entries;
+        for (const Entry& entry : owned) entries.push_back(&entry);
+        putEntries(out, entries, sizeof(Entry));
+        std::string message = std::move(out.finish());
+        message.erase(0, wire::FRAME_HEADER_BYTES);
+        transport.exchange({0}, {message});
+        return true;
+    }
+
+    std::vector<int> peers;
+    for (int peer = 1; peer < size; ++peer) peers.push_back(peer);
+    const std::vector<std::string> incoming =
+        transport.exchange(peers, std::vector<std::string>(peers.size()));
+
+    std::vector<RankStats> perRank{stats};
+    std::vector<Entry> all = owned;
+    for (const std::string& message : incoming) {
+        wire::Reader in(message.data(), message.size());
+        RankStats remote;
+        std::memcpy(&remote, in.getBytes(sizeof(remote)), sizeof(remote));
+        perRank.push_back(remote);
+        getEntries(in, all);
+    }
+
+    std::sort(all.begin(), all.end(), [](const Entry& a, const Entry& b) { return a.id < b.id; });
+    bool intact = all.size() == static_cast<size_t>(options.numBalls);
+    for (size_t i = 0; intact && i < all.size(); ++i) intact = all[i].id == i;
+    std::vector<Ball> balls;
+    balls.reserve(all.size());
+    for (const Entry& entry : all) balls.push_back(entry.ball);
+
+    const double steps = std::max(options.steps, 1);
+    uint64_t contacts = 0;
+    report << std::fixed << std::setprecision(3)
+           << "rank   balls  ghosts/step  migrations  compute ms/step  comm ms/step\n";
+    for (int r = 0; r < size; ++r) {
+        const RankStats& s = perRank[r];
+        contacts += s.contacts;
+        report << std::setw(4) << r << std::setw(8) << s.balls << std::setw(13) << s.ghosts / steps
+               << std::setw(12) << s.migrations << std::setw(17) << s.computeNs / steps / 1e6
+               << std::setw(14) << s.commNs / steps / 1e6 << "\n";
+    }
+    report << "balls " << balls.size() << " of " << options.numBalls
+           << (intact ? "" : " (LOST OR DUPLICATED)") << ", contacts " << contacts
+           << ", energy " << std::setprecision(6) << totalEnergy(balls, constants) << "\n";
+    if (!intact || !options.verify) return intact;
+
+    // Same seed and steps on one process; the tolerance is zero
+    std::vector<Ball> expected = generateBalls(options.numBalls, options.screenWidth,
+                                               options.screenHeight, options.seed);
+    auto reference = createBackend(backend::CPU_SERIAL);
+    reference->initialize(expected.size(), static_cast<int>(options.screenWidth),
+                          static_cast<int>(options.screenHeight));
+    reference->setConstants(constants);
+    reference->advance(expected, options.steps);
+    reference->cleanup();
+
+    const StepDivergence divergence = compareStates(expected, balls, constants);
+    if (divergence.bitwiseEqual) {
+        report << "matches " << backend::CPU_SERIAL << " bitwise\n";
+        return true;
+    }
+    report << "DIFFERS from " << backend::CPU_SERIAL << ": max position error "
+           << divergence.maxPositionError << " px, max velocity error "
+           << divergence.maxVelocityError << " px/s, energy difference "
+           << divergence.energyDifference << "\n";
+    return false;
+}
+
+int launchDistributed(const DistributedOptions& options, int argc, char* argv[]) {
+    if (options.ranks < 1 || options.ranks > config::Distributed::MAX_RANKS) {
+        throw std::invalid_argument("Rank count out of range");
+    }
+    if (options.screenWidth / options.ranks < 2.0f * config::Distributed::HALO) {
+        throw std::invalid_argument("Too many ranks: slabs would be narrower than two halos");
+    }
+    const auto mesh = LocalSocketTransport::createMesh(options.ranks);
+
+    std::vector<pid_t> children;
+    for (int rank = 1; rank < options.ranks; ++rank) {
+        std::ostringstream fdList;
+        for (int peer = 0; peer < options.ranks; ++peer) {
+            fdList << (peer ? "," : "") << mesh[rank][peer];
+        }
+        std::vector<std::string> args(argv, argv + argc);
+        args.insert(args.end(), {"--rank", std::to_string(rank), "--rank-fds", fdList.str()});
+        std::vector<char*> childArgv;
+        for (std::string& arg : args) childArgv.push_back(&arg[0]);
+        childArgv.push_back(nullptr);
+
+        // The child keeps only its own ends of the mesh, so it sees EOF
+        // when a peer exits
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        for (int a = 0; a < options.ranks; ++a) {
+            if (a == rank) continue;
+            for (int fd : mesh[a]) {
+                if (fd >= 0) posix_spawn_file_actions_addclose(&actions, fd);
+            }
+        }
+        pid_t pid = 0;
+        const int error = posix_spawn(&pid, "/proc/self/exe", &actions, nullptr,
+                                      childArgv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (error != 0) {
+            throw std::runtime_error(std::string("Failed to spawn rank: ") + std::strerror(error));
+        }
+        children.push_back(pid);
+    }
+
+    for (int rank = 1; rank < options.ranks; ++rank) {
+        for (int fd : mesh[rank]) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    int status = 0;
+    {
+        LocalSocketTransport transport(0, mesh[0]);
+        SIM_LOG_INFO << "Distributed run: " << options.ranks << " ranks, " << options.numBalls
+                     << " balls, " << options.steps << " steps";
+        try {
+            SlabRank rank(transport, options);
+            status = rank.run(std::cout) ? 0 : 2;
+        } catch (const std::exception& error) {
+            SIM_LOG_ERROR << "Rank 0 failed: " << error.what();
+            status = 1;
+        }
+    }
+
+    for (pid_t pid : children) {
+        int childStatus = 0;
+        if (waitpid(pid, &childStatus, 0) < 0 || !WIFEXITED(childStatus) ||
+            WEXITSTATUS(childStatus) != 0) {
+            status = status ? status : 1;
+        }
+    }
+    return status;
+}
+
+int runRank(const DistributedOptions& options, int rank, const std::string& fdList) {
+    std::vector<int> fds;
+    std::istringstream list(fdList);
+    for (std::string fd; std::getline(list, fd, ',');) fds.push_back(std::stoi(fd));
+    if (static_cast<int>(fds.size()) != options.ranks) {
+        throw std::invalid_argument("--rank-fds does not match --distributed");
+    }
+
+    LocalSocketTransport transport(rank, std::move(fds));
+    try {
+        SlabRank slab(transport, options);
+        std::ostringstream unused;
+        slab.run(unused);
+    } catch (const std::exception& error) {
+        SIM_LOG_ERROR << "Rank " << rank << " failed: " << error.what();
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace sim
@@ -1,7 +1,11 @@
 #include "GPUManager.h"
+#include "Trace.h"
+#include "Log.h"
 #include <fstream>
-#include <iostream>
+#include <cstdio>
 #include <filesystem>
+#include <thread>
+#include <chrono>
 
 namespace sim {
 
@@ -12,6 +16,11 @@ GPUManager::~GPUManager() {
 }
 
 void GPUManager::cleanup() {
+    plan.reset();
+    persistentKernel = cl::Kernel();
+    hostStates.clear();
+    hostProperties.clear();
+    propertiesUploaded = false;
     initialized = false;
 }
 
@@ -23,7 +32,7 @@ void GPUManager::initialize(size_t numBalls_, int screenWidth, int screenHeight)
         screen.width = screenWidth;
         screen.height = screenHeight;
 
-        std::cout << "Initializing GPU manager with " << numBalls << " balls" << std::endl;
+        SIM_LOG_INFO << "Initializing GPU manager with " << numBalls << " balls";
 
         createContext();
         buildProgram();
@@ -34,11 +43,16 @@ void GPUManager::initialize(size_t numBalls_, int screenWidth, int screenHeight)
             device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>(),
             size_t(256)
         );
+        if (persistent) {
+            createPersistentKernel();
+        }
+        prewarmKernels();
+        buildStepPlan();
 
         initialized = true;
 
     } catch (const std::exception& error) {
-        std::cerr << "Error during initialization: " << error.what() << std::endl;
+        SIM_LOG_ERROR << "Error during initialization: " << error.what();
         cleanup();
         throw;
     }
@@ -69,12 +83,32 @@ void GPUManager::createContext() {
             throw std::runtime_error("Failed to create OpenCL context");
         }
 
-        queue = cl::CommandQueue(context, device);
+        // Device timestamps feed the phase timings and the trace timeline.
+        // Commands carry explicit event dependencies, so an out-of-order
+        // queue can overlap the independent ones.
+        const cl_command_queue_properties supported =
+            device.getInfo<CL_DEVICE_QUEUE_PROPERTIES>();
+        outOfOrder = config::OpenCL::OUT_OF_ORDER_QUEUE &&
+                     (supported & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+        if (outOfOrder) {
+            try {
+                queue = cl::CommandQueue(context, device,
+                                         CL_QUEUE_PROFILING_ENABLE |
+                                         CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+            } catch (const cl::Error& e) {
+                SIM_LOG_WARN << "Out-of-order queue rejected (" << e.err() << "), using in-order";
+                outOfOrder = false;
+            }
+        }
+        if (!outOfOrder) {
+            queue = cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE);
+        }
+        SIM_LOG_INFO << "Command queue: " << (outOfOrder ? "out-of-order" : "in-order");
 
-        std::cout << "OpenCL context created successfully" << std::endl;
+        SIM_LOG_INFO << "OpenCL context created successfully";
 
     } catch (const cl::Error& e) {
-        std::cerr << "OpenCL error in createContext: " << e.what() << " (" << e.err() << ")" << std::endl;
+        SIM_LOG_ERROR << "OpenCL error in createContext: " << e.what() << " (" << e.err() << ")";
         throw;
     }
 }
@@ -85,11 +119,17 @@ void GPUManager::buildProgram() {
         cl::Program::Sources sources;
         sources.push_back({source.c_str(), source.length()});
         program = cl::Program(context, sources);
-        program.build("-cl-std=CL1.2");
+        std::string options = config::OpenCL::BUILD_OPTIONS;
+        if (math == KernelMath::Fast) {
+            options += config::OpenCL::FAST_MATH_OPTIONS;
+            SIM_LOG_INFO << "Building kernels with fast math";
+        }
+        program.build(options.c_str());
     }
     catch (const cl::Error& error) {
-        std::cerr << "Build error:" << std::endl;
-        std::cerr << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device) << std::endl;
+        // Build logs can be long; write them directly rather than truncated
+        SIM_LOG_ERROR << "Build error:";
+        std::fprintf(stderr, "%s\n", program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device).c_str());
         throw;
     }
 }
@@ -115,10 +155,16 @@ void GPUManager::createKernels() {
 }
 
 void GPUManager::createBuffers() {
-    ballsBuffer = cl::Buffer(
+    statesBuffer = cl::Buffer(
         context,
         CL_MEM_READ_WRITE,
-        sizeof(Ball) * numBalls
+        sizeof(BallState) * numBalls
+    );
+
+    propertiesBuffer = cl::Buffer(
+        context,
+        CL_MEM_READ_ONLY,
+        sizeof(BallProperties) * numBalls
     );
 
     constantsBuffer = cl::Buffer(
@@ -126,59 +172,293 @@ void GPUManager::createBuffers() {
         CL_MEM_READ_ONLY,
         sizeof(SimConstants)
     );
+
+    contactsBuffer = cl::Buffer(
+        context,
+        CL_MEM_READ_WRITE,
+        sizeof(cl_uint)
+    );
 }
 
-void GPUManager::updatePhysics(std::vector<Ball>& balls) {
+void GPUManager::buildStepPlan() {
+    // Every argument is fixed until the next initialize(); the constants
+    // buffer is rewritten each step but stays bound
+    physicsKernel.setArg(0, statesBuffer);
+    physicsKernel.setArg(1, propertiesBuffer);
+    physicsKernel.setArg(2, constantsBuffer);
+    physicsKernel.setArg(3, static_cast<int>(numBalls));
+
+    collisionKernel.setArg(0, statesBuffer);
+    collisionKernel.setArg(1, propertiesBuffer);
+    collisionKernel.setArg(2, constantsBuffer);
+    collisionKernel.setArg(3, static_cast<int>(numBalls));
+    collisionKernel.setArg(4, contactsBuffer);
+
+    const size_t globalSize = ((numBalls + workGroupSize - 1) / workGroupSize) * workGroupSize;
+    plan.build(device, queue, physicsKernel, collisionKernel, globalSize, workGroupSize);
+}
+
+void GPUManager::prewarmKernels() {
+    // Launch every kernel once over zero balls so the driver finishes its
+    // lazy compilation and allocation before the first real step.
+    // buildStepPlan() binds the real arguments afterwards.
+    const uint64_t startNs = trace::nowNs();
+    const int empty = 0;
+
+    physicsKernel.setArg(0, statesBuffer);
+    physicsKernel.setArg(1, propertiesBuffer);
+    physicsKernel.setArg(2, constantsBuffer);
+    physicsKernel.setArg(3, empty);
+    queue.enqueueNDRangeKernel(physicsKernel, cl::NullRange,
+                               cl::NDRange(workGroupSize), cl::NDRange(workGroupSize));
+
+    collisionKernel.setArg(0, statesBuffer);
+    collisionKernel.setArg(1, propertiesBuffer);
+    collisionKernel.setArg(2, constantsBuffer);
+    collisionKernel.setArg(3, empty);
+    collisionKernel.setArg(4, contactsBuffer);
+    queue.enqueueNDRangeKernel(collisionKernel, cl::NullRange,
+                               cl::NDRange(workGroupSize), cl::NDRange(workGroupSize));
+
+    if (persistentKernel()) {
+        persistentKernel.setArg(3, empty);
+        persistentKernel.setArg(4, empty);
+        queue.enqueueNDRangeKernel(persistentKernel, cl::NullRange,
+                                   cl::NDRange(persistentGroupSize),
+                                   cl::NDRange(persistentGroupSize));
+        persistentKernel.setArg(3, static_cast<int>(numBalls));
+    }
+
+    queue.finish();
+    SIM_LOG_INFO << "Kernels prewarmed in " << (trace::nowNs() - startNs) / 1e6 << " ms";
+}
+
+void GPUManager::createPersistentKernel() {
+    if (numBalls > config::OpenCL::PERSISTENT_MAX_BALLS) {
+        SIM_LOG_WARN << "Persistent kernel limited to " << config::OpenCL::PERSISTENT_MAX_BALLS
+                     << " balls; using per-step launches for " << numBalls;
+        return;
+    }
+
+    persistentKernel = cl::Kernel(program, "simulateSteps");
+    persistentGroupSize = std::min(
+        persistentKernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device),
+        config::OpenCL::WORKGROUP_SIZE
+    );
+    nextStatesBuffer = cl::Buffer(context, CL_MEM_READ_WRITE, sizeof(BallState) * numBalls);
+
+    persistentKernel.setArg(0, statesBuffer);
+    persistentKernel.setArg(1, propertiesBuffer);
+    persistentKernel.setArg(2, constantsBuffer);
+    persistentKernel.setArg(3, static_cast<int>(numBalls));
+    persistentKernel.setArg(5, nextStatesBuffer);
+    persistentKernel.setArg(6, contactsBuffer);
+
+    SIM_LOG_INFO << "Persistent kernel: one work-group of " << persistentGroupSize;
+}
+
+size_t GPUManager::uploadInputs(const std::vector<Ball>& balls, cl::Event& uploadStates,
+                                std::vector<cl::Event>& uploads) {
+    // Write the hot state to the device; properties never change
+    // between initialize() calls and are uploaded once
+    hostStates.resize(numBalls);
+    for (size_t i = 0; i < numBalls; ++i) {
+        hostStates[i] = stateOf(balls[i]);
+    }
+    // After the copy, so the trace's clock offset excludes it
+    uploadEnqueuedNs = trace::ENABLED ? trace::nowNs() : 0;
+    queue.enqueueWriteBuffer(statesBuffer, CL_FALSE, 0,
+                             sizeof(BallState) * numBalls, hostStates.data(),
+                             nullptr, &uploadStates);
+    uploads.push_back(uploadStates);
+
+    size_t propertyBytes = 0;
+    if (!propertiesUploaded) {
+        hostProperties.resize(numBalls);
+        for (size_t i = 0; i < numBalls; ++i) {
+            hostProperties[i] = propertiesOf(balls[i]);
+        }
+        propertyBytes = sizeof(BallProperties) * numBalls;
+        cl::Event uploadProperties;
+        queue.enqueueWriteBuffer(propertiesBuffer, CL_FALSE, 0,
+                                 propertyBytes, hostProperties.data(),
+                                 nullptr, &uploadProperties);
+        uploads.push_back(uploadProperties);
+        propertiesUploaded = true;
+    }
+
+    // Write constants to device
+    cl::Event uploadConstants;
+    queue.enqueueWriteBuffer(constantsBuffer, CL_FALSE, 0,
+                             sizeof(SimConstants), &constants,
+                             nullptr, &uploadConstants);
+    uploads.push_back(uploadConstants);
+    return propertyBytes;
+}
+
+void GPUManager::advance(std::vector<Ball>& balls, int steps) {
+    if (!persistentKernel()) {
+        PhysicsBackend::advance(balls, steps);
+        return;
+    }
+
     try {
-        // Write balls data to device
-        queue.enqueueWriteBuffer(ballsBuffer, CL_FALSE, 0,
-                                 sizeof(Ball) * numBalls, balls.data());
-
-        // Write constants to device
-        queue.enqueueWriteBuffer(constantsBuffer, CL_FALSE, 0,
-                                 sizeof(SimConstants), &constants);
-
-        // Set kernel arguments for physics update
-        physicsKernel.setArg(0, ballsBuffer);
-        physicsKernel.setArg(1, constantsBuffer);
-        physicsKernel.setArg(2, static_cast<int>(numBalls));
-
-        // Calculate work sizes
-        size_t globalSize = ((numBalls + workGroupSize - 1) / workGroupSize) * workGroupSize;
-
-        // Run physics kernel
-        queue.enqueueNDRangeKernel(
-            physicsKernel,
-            cl::NullRange,
-            cl::NDRange(globalSize),
-            cl::NDRange(workGroupSize)
-        );
+        SIM_TRACE_SCOPE("gpuAdvance");
+
+        cl::Event uploadStates, clearContacts, simulate, readback;
+        std::vector<cl::Event> deps;
+        const size_t propertyBytes = uploadInputs(balls, uploadStates, deps);
+        queue.enqueueFillBuffer(contactsBuffer, cl_uint(0), 0, sizeof(cl_uint),
+                                nullptr, &clearContacts);
+        deps.push_back(clearContacts);
+
+        persistentKernel.setArg(4, steps);
+        queue.enqueueNDRangeKernel(persistentKernel, cl::NullRange,
+                                   cl::NDRange(persistentGroupSize),
+                                   cl::NDRange(persistentGroupSize),
+                                   &deps, &simulate);
+        queue.flush();
+
+        // Completion comes from the kernel's event only: OpenCL 1.2 does
+        // not make writes of a running kernel visible to the host, so a
+        // device-side step counter could read stale. Negative statuses
+        // are errors, which the readback below reports.
+        while (simulate.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() > CL_COMPLETE) {
+            std::this_thread::sleep_for(
+                std::chrono::microseconds(config::OpenCL::PERSISTENT_POLL_MICROSECONDS));
+        }
 
-        // Set kernel arguments for collision detection
-        collisionKernel.setArg(0, ballsBuffer);
-        collisionKernel.setArg(1, constantsBuffer);
-        collisionKernel.setArg(2, static_cast<int>(numBalls));
-
-        // Run collision kernel
-        queue.enqueueNDRangeKernel(
-            collisionKernel,
-            cl::NullRange,
-            cl::NDRange(globalSize),
-            cl::NDRange(workGroupSize)
-        );
+        const std::vector<cl::Event> readDeps{simulate};
+        cl::Event readContacts;
+        queue.enqueueReadBuffer(contactsBuffer, CL_FALSE, 0, sizeof(cl_uint), &contactCount,
+                                &readDeps, &readContacts);
+        queue.enqueueReadBuffer(statesBuffer, CL_FALSE, 0,
+                                sizeof(BallState) * numBalls, hostStates.data(),
+                                &readDeps, &readback);
+        queue.flush();
+        cl::Event::waitForEvents({readContacts, readback});
+
+        for (size_t i = 0; i < numBalls; ++i) {
+            storeState(balls[i], hostStates[i]);
+        }
+
+        // Both phases run inside the one kernel
+        stepStats.integrateNs = 0;
+        stepStats.narrowphaseNs = commandDurationNs(simulate);
+        stepStats.contacts = contactCount;
+        stepStats.bytesTransferred = 2 * sizeof(BallState) * numBalls + propertyBytes +
+                                     sizeof(SimConstants) + sizeof(cl_uint);
+
+    } catch (const cl::Error& error) {
+        SIM_LOG_ERROR << "OpenCL error in persistent update: " << error.what()
+                      << " (" << error.err() << ")";
+        throw;
+    }
+}
+
+void GPUManager::updatePhysics(std::vector<Ball>& balls) {
+    if (persistentKernel()) {
+        advance(balls, 1);
+        return;
+    }
+
+    cl::Event events[DeviceCommand::COUNT];
+
+    // Step DAG; edges hold on either queue type:
+    //
+    //   upload states --+
+    //   upload props ---+--> integrate --+--> collide --+--> read states
+    //   upload consts --+                |              +--> read contacts
+    //   clear contacts ------------------+
+    std::vector<cl::Event> integrateDeps;
+    std::vector<cl::Event> collideDeps;
+    cl::Event clearContacts, readContacts;
 
-        // Read updated balls data back to host
-        queue.enqueueReadBuffer(ballsBuffer, CL_TRUE, 0,
-                                sizeof(Ball) * numBalls, balls.data());
+    try {
+        SIM_TRACE_SCOPE("gpuUpdate");
+
+        const size_t propertyBytes =
+            uploadInputs(balls, events[DeviceCommand::Upload], integrateDeps);
+
+        // Reset the contact counter; only the collision pass waits on it
+        queue.enqueueFillBuffer(contactsBuffer, cl_uint(0), 0, sizeof(cl_uint),
+                                nullptr, &clearContacts);
+
+        // Integrate and collide from the prebuilt plan
+        collideDeps.push_back(clearContacts);
+        plan.enqueue(queue, integrateDeps, collideDeps,
+                     events[DeviceCommand::Integrate], events[DeviceCommand::Collide]);
+
+        // Read contact count and updated balls data back to host; the two
+        // reads are independent of each other
+        const std::vector<cl::Event> readDeps{events[DeviceCommand::Collide]};
+        queue.enqueueReadBuffer(contactsBuffer, CL_FALSE, 0,
+                                sizeof(cl_uint), &contactCount,
+                                &readDeps, &readContacts);
+        queue.enqueueReadBuffer(statesBuffer, CL_FALSE, 0,
+                                sizeof(BallState) * numBalls, hostStates.data(),
+                                &readDeps, &events[DeviceCommand::Readback]);
+        queue.flush();
+        cl::Event::waitForEvents({readContacts, events[DeviceCommand::Readback]});
+
+        for (size_t i = 0; i < numBalls; ++i) {
+            storeState(balls[i], hostStates[i]);
+        }
 
-        queue.finish();
+        // The brute-force kernel has no separate broadphase. A recorded
+        // plan times both kernels as one command, reported as narrowphase.
+        if (plan.recorded()) {
+            stepStats.integrateNs = 0;
+        } else {
+            stepStats.integrateNs = commandDurationNs(events[DeviceCommand::Integrate]);
+        }
+        stepStats.narrowphaseNs = commandDurationNs(events[DeviceCommand::Collide]);
+        stepStats.contacts = contactCount;
+        stepStats.bytesTransferred = 2 * sizeof(BallState) * numBalls + propertyBytes +
+                                     sizeof(SimConstants) + sizeof(cl_uint);
+
+        if (trace::ENABLED) {
+            traceDeviceCommands(events);
+        }
 
     } catch (const cl::Error& error) {
-        std::cerr << "OpenCL error in physics update: " << error.what()
-                  << " (" << error.err() << ")" << std::endl;
+        SIM_LOG_ERROR << "OpenCL error in physics update: " << error.what()
+                      << " (" << error.err() << ")";
         throw;
     }
 }
 
-} // namespace sim
+uint64_t GPUManager::commandDurationNs(const cl::Event& event) {
+    return event.getProfilingInfo<CL_PROFILING_COMMAND_END>() -
+           event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+}
 
+void GPUManager::traceDeviceCommands(const cl::Event* events) {
+    static constexpr const char* TRACK = "OpenCL device";
+    static constexpr const char* NAMES[DeviceCommand::COUNT] = {
+        "writeBuffer", "updateBallPhysics", "detectCollisions", "readBuffer"
+    };
+
+    // The upload's QUEUED timestamp is the device clock when it was
+    // enqueued, and uploadEnqueuedNs the host clock just before that call,
+    // which gives the clock offset. clGetDeviceAndHostTimer would be exact
+    // but needs OpenCL 2.1.
+    const int64_t deviceQueued = static_cast<int64_t>(
+        events[DeviceCommand::Upload].getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>());
+    const int64_t offset = static_cast<int64_t>(uploadEnqueuedNs) - deviceQueued;
+
+    for (int i = 0; i < DeviceCommand::COUNT; ++i) {
+        // A recorded plan shares one event between both kernels
+        if (plan.recorded() && i == DeviceCommand::Integrate) continue;
+        const char* name = plan.recorded() && i == DeviceCommand::Collide ? "stepPlan" : NAMES[i];
+        const int64_t start = static_cast<int64_t>(
+            events[i].getProfilingInfo<CL_PROFILING_COMMAND_START>());
+        const int64_t end = static_cast<int64_t>(
+            events[i].getProfilingInfo<CL_PROFILING_COMMAND_END>());
+        trace::recordTrackSpan(TRACK, name,
+                               static_cast<uint64_t>(std::max<int64_t>(0, start + offset)),
+                               static_cast<uint64_t>(std::max<int64_t>(0, end + offset)));
+    }
+}
+
+} // namespace sim
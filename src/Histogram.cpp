@@ -0,0 +1,119 @@
+#include "Histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+namespace sim {
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);
+    }
+    // Position of the highest set bit, >= SUB_BITS here
+    int exponent = 63;
+    while (!(value >> exponent)) --exponent;
+    const int shift = exponent - SUB_BITS;
+    const uint64_t sub = (value >> shift) & (SUB_BUCKETS - 1);
+    return static_cast<size_t>(SUB_BUCKETS + shift * SUB_BUCKETS + sub);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    const int shift = static_cast<int>((index - SUB_BUCKETS) / SUB_BUCKETS);
+    const uint64_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    const uint64_t lower = (SUB_BUCKETS + sub) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t valueNs) {
+    buckets[bucketIndex(valueNs)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(valueNs, std::memory_order_relaxed);
+
+    uint64_t current = maxValue.load(std::memory_order_relaxed);
+    while (valueNs > current &&
+           !maxValue.compare_exchange_weak(current, valueNs, std::memory_order_relaxed)) {
+    }
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    maxValue.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::percentile(double quantile) const {
+    const uint64_t n = count();
+    if (n == 0) return 0;
+
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * n)));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), max());
+        }
+    }
+    return max();
+}
+
+uint64_t LatencyHistogram::countAtOrBelow(uint64_t limitNs) const {
+    uint64_t below = 0;
+    for (size_t i = 0; i < BUCKET_COUNT && bucketUpperBound(i) <= limitNs; ++i) {
+        below += buckets[i].load(std::memory_order_relaxed);
+    }
+    return below;
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const {
+    Summary s;
+    s.count = count();
+    s.p50 = percentile(0.50);
+    s.p99 = percentile(0.99);
+    s.p999 = percentile(0.999);
+    s.max = max();
+    s.mean = s.count ? static_cast<double>(sum.load(std::memory_order_relaxed)) / s.count : 0.0;
+    return s;
+}
+
+void LatencyStats::reset() {
+    physicsStep.reset();
+    broadphase.reset();
+    narrowphase.reset();
+    frame.reset();
+    snapshotAge.reset();
+}
+
+void LatencyStats::print(std::ostream& out) const {
+    auto ms = [](uint64_t ns) { return ns / 1e6; };
+    auto row = [&](const char* name, const LatencyHistogram& histogram) {
+        const auto s = histogram.summary();
+        if (s.count == 0) return;
+        out << "  " << std::left << std::setw(14) << name << std::right
+            << std::setw(9) << s.count
+            << std::setw(10) << ms(s.p50)
+            << std::setw(10) << ms(s.p99)
+            << std::setw(10) << ms(s.p999)
+            << std::setw(10) << ms(s.max) << "\n";
+    };
+
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(3)
+        << "Latency (ms)       count       p50       p99     p99.9       max\n";
+    row("physics step", physicsStep);
+    row("broadphase", broadphase);
+    row("narrowphase", narrowphase);
+    row("frame", frame);
+    row("snapshot age", snapshotAge);
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace sim
@@ -0,0 +1,181 @@
+#include "Log.h"
+#include "Trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sim {
+namespace log {
+
+namespace {
+
+struct Record {
+    uint64_t timeNs;
+    Level level;
+    uint16_t length;
+    char text[config::Log::LINE_CAPACITY];
+};
+
+// Single-producer/single-consumer ring owned by one logging thread
+struct Ring {
+    Record slots[config::Log::RING_SLOTS];
+    std::atomic<size_t> head{0}; // next slot to write (producer)
+    std::atomic<size_t> tail{0}; // next slot to read (consumer)
+
+    bool push(uint64_t timeNs, Level level, const char* text, size_t length) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= config::Log::RING_SLOTS) {
+            return false;
+        }
+        Record& record = slots[h % config::Log::RING_SLOTS];
+        record.timeNs = timeNs;
+        record.level = level;
+        record.length = static_cast<uint16_t>(length);
+        std::char_traits<char>::copy(record.text, text, length);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+struct Logger {
+    std::mutex mutex; // guards rings and the writer thread lifecycle
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint32_t> submitting{0}; // submit() calls that saw running set
+    std::thread writer;
+    std::condition_variable wake;
+};
+
+Logger& logger() {
+    static Logger instance;
+    return instance;
+}
+
+Ring& localRing() {
+    thread_local std::shared_ptr<Ring> ring = [] {
+        Logger& log = logger();
+        auto created = std::make_shared<Ring>();
+        std::lock_guard<std::mutex> lock(log.mutex);
+        log.rings.push_back(created);
+        return created;
+    }();
+    return *ring;
+}
+
+const char* levelTag(Level level) {
+    switch (level) {
+        case Level::Debug: return "DEBUG ";
+        case Level::Warn: return "WARN ";
+        case Level::Error: return "ERROR ";
+        default: return "";
+    }
+}
+
+void writeLine(uint64_t timeNs, Level level, const char* text, size_t length) {
+    // Diagnostics go to stderr so stdout stays clean for reports
+    std::fprintf(stderr, "[%10.6f] %s%.*s\n", timeNs / 1e9, levelTag(level),
+                 static_cast<int>(length), text);
+}
+
+// Moves every pending record out of the rings, oldest first
+void drain(std::vector<Record>& batch) {
+    Logger& log = logger();
+    batch.clear();
+    {
+        std::lock_guard<std::mutex> lock(log.mutex);
+        for (auto& ring : log.rings) {
+            const size_t t = ring->tail.load(std::memory_order_relaxed);
+            const size_t h = ring->head.load(std::memory_order_acquire);
+            for (size_t i = t; i < h; ++i) {
+                batch.push_back(ring->slots[i % config::Log::RING_SLOTS]);
+            }
+            ring->tail.store(h, std::memory_order_release);
+        }
+    }
+
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const Record& a, const Record& b) { return a.timeNs < b.timeNs; });
+    for (const auto& record : batch) {
+        writeLine(record.timeNs, record.level, record.text, record.length);
+    }
+}
+
+void writerLoop() {
+    SIM_TRACE_THREAD("logger");
+    Logger& log = logger();
+    std::vector<Record> batch;
+
+    while (log.running.load(std::memory_order_acquire)) {
+        {
+            std::unique_lock<std::mutex> lock(log.mutex);
+            log.wake.wait_for(lock, std::chrono::milliseconds(config::Log::FLUSH_INTERVAL_MS));
+        }
+        drain(batch);
+    }
+    drain(batch);
+}
+
+} // namespace
+
+void start() {
+    Logger& log = logger();
+    std::lock_guard<std::mutex> lock(log.mutex);
+    if (log.running.exchange(true)) return;
+    log.writer = std::thread(writerLoop);
+}
+
+void stop() {
+    Logger& log = logger();
+    std::thread writer;
+    {
+        std::lock_guard<std::mutex> lock(log.mutex);
+        if (!log.running.exchange(false)) return;
+        writer = std::move(log.writer);
+    }
+    log.wake.notify_one();
+    writer.join();
+
+    // A submit() that saw running just before it was cleared may have
+    // pushed after the writer's last drain; wait for it and drain again
+    while (log.submitting.load()) std::this_thread::yield();
+    std::vector<Record> batch;
+    drain(batch);
+
+    if (const uint64_t lost = log.dropped.load(std::memory_order_relaxed)) {
+        std::fprintf(stderr, "%llu log line(s) dropped (ring full)\n",
+                     static_cast<unsigned long long>(lost));
+    }
+}
+
+void submit(Level level, const char* text, size_t length) {
+    const uint64_t now = trace::nowNs();
+    Logger& log = logger();
+
+    // Sequentially consistent with stop(): either stop() sees this call
+    // in flight, or this call sees running cleared
+    log.submitting.fetch_add(1);
+    if (!log.running.load()) {
+        log.submitting.fetch_sub(1);
+        writeLine(now, level, text, length);
+        return;
+    }
+
+    if (!localRing().push(now, level, text, length)) {
+        log.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    log.submitting.fetch_sub(1);
+}
+
+uint64_t droppedLines() {
+    return logger().dropped.load(std::memory_order_relaxed);
+}
+
+} // namespace log
+} // namespace sim
@@ -0,0 +1,100 @@
+#include "Memory.h"
+#include "Log.h"
+#include <atomic>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace sim {
+namespace memory {
+
+namespace {
+
+std::atomic<HugePages> g_mode{HugePages::Off};
+std::atomic<bool> g_poolEmptyReported{false};
+
+// Small blocks are cache-line aligned, which covers every physics type
+constexpr std::align_val_t SMALL_ALIGNMENT{64};
+
+size_t roundToHugePage(size_t bytes) {
+    const size_t unit = config::Memory::HUGE_PAGE_BYTES;
+    return (bytes + unit - 1) / unit * unit;
+}
+
+bool isLarge(size_t bytes) {
+#ifdef __linux__
+    return bytes >= config::Memory::LARGE_ALLOCATION_BYTES;
+#else
+    (void)bytes;
+    return false;
+#endif
+}
+
+} // namespace
+
+void setHugePages(HugePages mode) {
+    g_mode.store(mode, std::memory_order_relaxed);
+}
+
+HugePages hugePages() {
+    return g_mode.load(std::memory_order_relaxed);
+}
+
+HugePages parseHugePages(const std::string& text) {
+    if (text == "off") return HugePages::Off;
+    if (text == "thp") return HugePages::Transparent;
+    if (text == "explicit") return HugePages::Explicit;
+    throw std::invalid_argument("Unknown huge page mode: " + text);
+}
+
+void* allocateLarge(size_t bytes) {
+    if (!isLarge(bytes)) {
+        return ::operator new(bytes, SMALL_ALIGNMENT);
+    }
+
+#ifdef __linux__
+    const size_t length = roundToHugePage(bytes);
+    const HugePages mode = hugePages();
+    void* pointer = MAP_FAILED;
+
+    if (mode == HugePages::Explicit) {
+        pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (pointer == MAP_FAILED && !g_poolEmptyReported.exchange(true)) {
+            SIM_LOG_WARN << "No explicit huge pages available (vm.nr_hugepages), falling back to THP";
+        }
+    }
+    if (pointer == MAP_FAILED) {
+        pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pointer == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        if (mode != HugePages::Off) {
+            // Also the fallback for an empty hugetlbfs pool
+            madvise(pointer, length, MADV_HUGEPAGE);
+        }
+    }
+    return pointer;
+#else
+    return nullptr;
+#endif
+}
+
+void freeLarge(void* pointer, size_t bytes) {
+    if (!pointer) return;
+
+    if (!isLarge(bytes)) {
+        ::operator delete(pointer, SMALL_ALIGNMENT);
+        return;
+    }
+
+#ifdef __linux__
+    munmap(pointer, roundToHugePage(bytes));
+#endif
+}
+
+} // namespace memory
+} // namespace sim
@@ -0,0 +1,74 @@
+#include "Metrics.h"
+#include "Config.h"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+
+namespace sim {
+
+void MetricsRegistry::add(const std::string& name, const std::string& help,
+                          Type type, const void* metric) {
+    entries.push_back({config::Metrics::PREFIX + name, help, type, metric});
+}
+
+MetricCounter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex);
+    MetricCounter& metric = counters.emplace_back();
+    add(name, help, Type::Counter, &metric);
+    return metric;
+}
+
+MetricGauge& MetricsRegistry::gauge(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex);
+    MetricGauge& metric = gauges.emplace_back();
+    add(name, help, Type::Gauge, &metric);
+    return metric;
+}
+
+LatencyHistogram& MetricsRegistry::histogram(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex);
+    LatencyHistogram& metric = histograms.emplace_back();
+    add(name, help, Type::Histogram, &metric);
+    return metric;
+}
+
+void MetricsRegistry::attachHistogram(const std::string& name, const std::string& help,
+                                      const LatencyHistogram& histogram) {
+    std::lock_guard<std::mutex> lock(mutex);
+    add(name, help, Type::Histogram, &histogram);
+}
+
+void MetricsRegistry::writePrometheus(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    out << std::setprecision(9);
+
+    for (const auto& entry : entries) {
+        out << "# HELP " << entry.name << " " << entry.help << "\n";
+        switch (entry.type) {
+            case Type::Counter:
+                out << "# TYPE " << entry.name << " counter\n"
+                    << entry.name << " " << static_cast<const MetricCounter*>(entry.metric)->get() << "\n";
+                break;
+            case Type::Gauge:
+                out << "# TYPE " << entry.name << " gauge\n"
+                    << entry.name << " " << static_cast<const MetricGauge*>(entry.metric)->get() << "\n";
+                break;
+            case Type::Histogram: {
+                // Latencies are recorded in ns and exposed in seconds
+                const auto* histogram = static_cast<const LatencyHistogram*>(entry.metric);
+                const uint64_t count = histogram->count();
+                out << "# TYPE " << entry.name << " histogram\n";
+                for (double le : config::Metrics::HISTOGRAM_BOUNDS_SECONDS) {
+                    out << entry.name << "_bucket{le=\"" << le << "\"} "
+                        << std::min(count, histogram->countAtOrBelow(static_cast<uint64_t>(le * 1e9))) << "\n";
+                }
+                out << entry.name << "_bucket{le=\"+Inf\"} " << count << "\n"
+                    << entry.name << "_sum " << histogram->sumNs() / 1e9 << "\n"
+                    << entry.name << "_count " << count << "\n";
+                break;
+            }
+        }
+    }
+}
+
+} // namespace sim
@@ -0,0 +1,140 @@
+#include "MetricsServer.h"
+#include "Config.h"
+#include "Trace.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+namespace sim {
+
+MetricsServer::MetricsServer(const MetricsRegistry& registry_, std::string endpoint_)
+    : registry(registry_)
+    , endpointSpec(std::move(endpoint_))
+{
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::start() {
+    if (running.exchange(true)) return;
+    try {
+        listenFd = openListener();
+    } catch (...) {
+        running = false;
+        throw;
+    }
+    thread = std::thread(&MetricsServer::serveLoop, this);
+}
+
+void MetricsServer::stop() {
+    if (!running.exchange(false)) return;
+    if (thread.joinable()) thread.join();
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+    }
+    if (!unixPath.empty()) {
+        unlink(unixPath.c_str());
+    }
+}
+
+int MetricsServer::openListener() {
+    static constexpr const char* UNIX_PREFIX = "unix:";
+    int fd = -1;
+
+    if (endpointSpec.rfind(UNIX_PREFIX, 0) == 0) {
+        unixPath = endpointSpec.substr(std::strlen(UNIX_PREFIX));
+        sockaddr_un addr{};
+        if (unixPath.empty() || unixPath.size() >= sizeof(addr.sun_path)) {
+            throw std::runtime_error("Invalid metrics socket path: " + unixPath);
+        }
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, unixPath.c_str(), sizeof(addr.sun_path) - 1);
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(unixPath.c_str()); // stale socket from a previous run
+        if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            const std::string reason = std::strerror(errno);
+            if (fd >= 0) close(fd);
+            throw std::runtime_error("Failed to bind metrics socket " + unixPath + ": " + reason);
+        }
+    } else {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(std::stoi(endpointSpec)));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        const int reuse = 1;
+        if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            const std::string reason = std::strerror(errno);
+            if (fd >= 0) close(fd);
+            throw std::runtime_error("Failed to bind metrics port " + endpointSpec + ": " + reason);
+        }
+    }
+
+    if (listen(fd, 8) < 0) {
+        const std::string reason = std::strerror(errno);
+        close(fd);
+        throw std::runtime_error("Failed to listen on metrics endpoint: " + reason);
+    }
+    return fd;
+}
+
+void MetricsServer::serveLoop() {
+    SIM_TRACE_THREAD("metrics");
+
+    while (running) {
+        // Wake up periodically to notice stop()
+        pollfd pfd{listenFd, POLLIN, 0};
+        const int ready = poll(&pfd, 1, config::Metrics::POLL_INTERVAL_MS);
+        if (ready <= 0 || !(pfd.revents & POLLIN)) continue;
+
+        const int client = accept(listenFd, nullptr, nullptr);
+        if (client < 0) continue;
+        handleClient(client);
+        close(client);
+    }
+}
+
+void MetricsServer::handleClient(int client) {
+    SIM_TRACE_SCOPE("metricsScrape");
+
+    // Drain whatever request the client sent; the path is ignored
+    pollfd pfd{client, POLLIN, 0};
+    if (poll(&pfd, 1, config::Metrics::POLL_INTERVAL_MS) > 0) {
+        char request[1024];
+        (void)recv(client, request, sizeof(request), 0);
+    }
+
+    std::ostringstream body;
+    registry.writePrometheus(body);
+    const std::string payload = body.str();
+
+    std::ostringstream response;
+    response << "HTTP/1.0 200 OK\r\n"
+             << "Content-Type: text/plain; version=0.0.4\r\n"
+             << "Content-Length: " << payload.size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << payload;
+    const std::string data = response.str();
+
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = send(client, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += static_cast<size_t>(n);
+    }
+}
+
+} // namespace sim
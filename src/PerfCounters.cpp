@@ -0,0 +1,173 @@
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+namespace sim {
+namespace perf {
+
+namespace {
+
+std::atomic<bool> g_enabled{false};
+std::atomic<bool> g_available{false};
+
+struct AtomicTotals {
+    std::atomic<uint64_t> values[COUNTER_COUNT]{};
+    std::atomic<uint64_t> scopes{0};
+};
+
+AtomicTotals g_totals[static_cast<int>(Phase::COUNT)];
+
+#ifdef __linux__
+// One counter group per thread, opened on first use and kept for the
+// lifetime of the thread. The group runs continuously; scopes read deltas.
+class ThreadCounters {
+public:
+    ThreadCounters() {
+        static constexpr uint64_t CONFIGS[COUNTER_COUNT] = {
+            PERF_COUNT_HW_CPU_CYCLES,
+            PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES,
+        };
+
+        for (int i = 0; i < COUNTER_COUNT; ++i) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = CONFIGS[i];
+            attr.disabled = i == 0 ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+
+            const int groupFd = i == 0 ? -1 : fds[0];
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+            if (fds[i] < 0) {
+                close();
+                return;
+            }
+        }
+
+        ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        open = true;
+        g_available.store(true, std::memory_order_relaxed);
+    }
+
+    ~ThreadCounters() { close(); }
+
+    bool read(uint64_t out[COUNTER_COUNT]) const {
+        if (!open) return false;
+        struct {
+            uint64_t nr;
+            uint64_t values[COUNTER_COUNT];
+        } group;
+        if (::read(fds[0], &group, sizeof(group)) != static_cast<ssize_t>(sizeof(group))) {
+            return false;
+        }
+        for (int i = 0; i < COUNTER_COUNT; ++i) out[i] = group.values[i];
+        return true;
+    }
+
+private:
+    void close() {
+        for (int& fd : fds) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+        open = false;
+    }
+
+    int fds[COUNTER_COUNT]{-1, -1, -1, -1};
+    bool open{false};
+};
+
+ThreadCounters& threadCounters() {
+    thread_local ThreadCounters counters;
+    return counters;
+}
+#endif
+
+} // namespace
+
+const char* phaseName(Phase phase) {
+    switch (phase) {
+        case Phase::Integrate: return "integrate";
+        case Phase::Broadphase: return "broadphase";
+        case Phase::Narrowphase: return "narrowphase";
+        case Phase::Publish: return "publish";
+        default: return "unknown";
+    }
+}
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+        case Cycles: return "cycles";
+        case Instructions: return "instructions";
+        case CacheMisses: return "cache_misses";
+        case BranchMisses: return "branch_misses";
+        default: return "unknown";
+    }
+}
+
+void setEnabled(bool enabled_) {
+    g_enabled.store(enabled_, std::memory_order_relaxed);
+}
+
+bool enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+bool available() {
+    return g_available.load(std::memory_order_relaxed);
+}
+
+PhaseTotals totals(Phase phase) {
+    const AtomicTotals& source = g_totals[static_cast<int>(phase)];
+    PhaseTotals result;
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        result.values[i] = source.values[i].load(std::memory_order_relaxed);
+    }
+    result.scopes = source.scopes.load(std::memory_order_relaxed);
+    return result;
+}
+
+void resetTotals() {
+    for (auto& phaseTotals : g_totals) {
+        for (auto& value : phaseTotals.values) value.store(0, std::memory_order_relaxed);
+        phaseTotals.scopes.store(0, std::memory_order_relaxed);
+    }
+}
+
+PhaseScope::PhaseScope(Phase phase_)
+    : phase(phase_)
+{
+#ifdef __linux__
+    if (enabled()) {
+        active = threadCounters().read(start);
+    }
+#endif
+}
+
+PhaseScope::~PhaseScope() {
+#ifdef __linux__
+    uint64_t end[COUNTER_COUNT];
+    if (!active || !threadCounters().read(end)) return;
+
+    AtomicTotals& target = g_totals[static_cast<int>(phase)];
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        target.values[i].fetch_add(end[i] - start[i], std::memory_order_relaxed);
+    }
+    target.scopes.fetch_add(1, std::memory_order_relaxed);
+#endif
+}
+
+} // namespace perf
+} // namespace sim
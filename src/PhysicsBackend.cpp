@@ -0,0 +1,36 @@
+#include "PhysicsBackend.h"
+#include "GPUManager.h"
+#include "CPUPhysics.h"
+#include <stdexcept>
+
+namespace sim {
+
+std::unique_ptr<PhysicsBackend> createBackend(const std::string& name) {
+    if (name == backend::OPENCL) {
+        return std::make_unique<GPUManager>();
+    }
+    if (name == backend::OPENCL_FAST) {
+        return std::make_unique<GPUManager>(KernelMath::Fast);
+    }
+    if (name == backend::OPENCL_PERSISTENT) {
+        return std::make_unique<GPUManager>(KernelMath::Precise, true);
+    }
+    if (name == backend::CPU) {
+        return std::make_unique<CPUPhysics>();
+    }
+    if (name == backend::CPU_SERIAL) {
+        return std::make_unique<CPUPhysics>(1);
+    }
+    if (name == backend::CPU_SOA) {
+        return std::make_unique<BasicCPUPhysics<layout::Soa>>();
+    }
+    if (name == backend::CPU_AOSOA8) {
+        return std::make_unique<BasicCPUPhysics<layout::Aosoa<8>>>();
+    }
+    if (name == backend::CPU_AOSOA16) {
+        return std::make_unique<BasicCPUPhysics<layout::Aosoa<16>>>();
+    }
+    throw std::invalid_argument("Unknown physics backend: " + name);
+}
+
+} // namespace sim
@@ -1,10 +1,12 @@
 #include "Renderer.h"
 #include "Config.h"
+#include "Trace.h"
+#include "Font.h"
+#include "Log.h"
 #include <stdexcept>
 #include <cmath>
 #include <sstream>
 #include <iomanip>
-#include <iostream>
 #include <algorithm>
 
 // Removed GLUT include
@@ -19,7 +21,7 @@ Renderer::GLFWContext::GLFWContext() {
     if (!glfwInit()) {
         throw std::runtime_error("Failed to initialize GLFW");
     }
-    std::cout << "GLFW initialized successfully\n";
+    SIM_LOG_INFO << "GLFW initialized successfully";
 }
 
 Renderer::GLFWContext::~GLFWContext() {
@@ -31,6 +33,8 @@ Renderer::Renderer(int width_, int height_)
 }
 
 Renderer::~Renderer() {
+    // The atlas belongs to the render thread's context, which is released
+    // before the renderer is destroyed; destroying the window frees it.
     if (window) {
         glfwDestroyWindow(window);
     }
@@ -57,7 +61,7 @@ bool Renderer::initialize(size_t numBalls_) {
     // Do not make the context current here
     // Context will be made current in the render thread
 
-    std::cout << "OpenGL Renderer initialized\n";
+    SIM_LOG_INFO << "OpenGL Renderer initialized";
 
     return true;
 }
@@ -100,24 +104,33 @@ void Renderer::setupOpenGL() {
     // Set framebuffer size callback
     glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
 
-    std::cout << "OpenGL setup completed:\n"
-              << "  Version: " << glGetString(GL_VERSION) << "\n"
-              << "  Vendor: " << glGetString(GL_VENDOR) << "\n"
-              << "  Renderer: " << glGetString(GL_RENDERER) << "\n\n";
+    createGlyphAtlas();
+
+    SIM_LOG_INFO << "OpenGL setup completed";
+    SIM_LOG_INFO << "  Version: " << glGetString(GL_VERSION);
+    SIM_LOG_INFO << "  Vendor: " << glGetString(GL_VENDOR);
+    SIM_LOG_INFO << "  Renderer: " << glGetString(GL_RENDERER);
 }
 
-void Renderer::render(const std::vector<Ball>& balls, double fps) {
+void Renderer::render(const std::vector<Ball>& balls, const OverlayStats* overlay) {
     // Clear the screen
     glClear(GL_COLOR_BUFFER_BIT);
     glLoadIdentity();
 
     // Draw balls
-    drawBalls(balls);
+    {
+        SIM_TRACE_SCOPE("drawBalls");
+        drawBalls(balls);
+    }
 
-    // Optionally draw FPS counter
-    // renderFPS(fps);
+    // Optionally draw the performance overlay
+    if (overlay) {
+        SIM_TRACE_SCOPE("drawOverlay");
+        renderOverlay(*overlay);
+    }
 
     // Swap buffers and poll events
+    SIM_TRACE_SCOPE("swapBuffers");
     glfwSwapBuffers(window);
     glfwPollEvents();
 }
@@ -153,14 +166,135 @@ void Renderer::drawCircle(float x, float y, float radius, uint32_t color, float
     glEnd();
 }
 
-void Renderer::renderFPS(double fps) {
-    // FPS rendering is disabled (no GLUT)
-    // You can implement text rendering using another method if needed
+void Renderer::createGlyphAtlas() {
+    // One cell per printable character plus a solid cell for panel quads
+    std::vector<GLubyte> pixels(ATLAS_SIZE * ATLAS_SIZE, 0);
+    for (int cell = 0; cell <= font::GLYPH_COUNT; ++cell) {
+        const int originX = (cell % ATLAS_COLUMNS) * font::GLYPH_WIDTH;
+        const int originY = (cell / ATLAS_COLUMNS) * font::GLYPH_HEIGHT;
+        for (int row = 0; row < font::GLYPH_HEIGHT; ++row) {
+            const uint8_t bits = cell < font::GLYPH_COUNT ? font::GLYPHS[cell][row] : 0xFF;
+            for (int col = 0; col < font::GLYPH_WIDTH; ++col) {
+                if (bits & (0x80 >> col)) {
+                    pixels[(originY + row) * ATLAS_SIZE + originX + col] = 0xFF;
+                }
+            }
+        }
+    }
+
+    glGenTextures(1, &glyphTexture);
+    glBindTexture(GL_TEXTURE_2D, glyphTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_SIZE, ATLAS_SIZE, 0,
+                 GL_ALPHA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Renderer::renderOverlay(const OverlayStats& overlay) {
+    std::vector<std::string> lines;
+    auto line = [&](auto&&... parts) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        (out << ... << parts);
+        lines.push_back(out.str());
+    };
+
+    line("FPS          ", std::setprecision(1), overlay.fps);
+    line("Physics      ", std::setprecision(1), overlay.physicsRate, " steps/s (", overlay.backendName, ")");
+    line("Step p50     ", overlay.stepP50Ms, " ms");
+    line("Step p99     ", overlay.stepP99Ms, " ms");
+    line("Step p99.9   ", overlay.stepP999Ms, " ms");
+    line("Balls        ", overlay.ballCount);
+    line("Contacts     ", overlay.contactsPerStep, " /step");
+    if (overlay.transferMBps > 0.0) {
+        line("Transfer     ", std::setprecision(1), overlay.transferMBps, " MB/s");
+    }
+
+    const float scale = TEXT_SCALE;
+    const float lineHeight = font::GLYPH_HEIGHT * scale;
+    const float margin = 8.0f;
+    size_t longest = 0;
+    for (const auto& text : lines) longest = std::max(longest, text.size());
+
+    static constexpr GLubyte PANEL_COLOR[4] = {0, 0, 0, 160};
+    drawPanel(margin, margin,
+              longest * font::GLYPH_WIDTH * scale + 2 * margin,
+              lines.size() * lineHeight + 2 * margin, PANEL_COLOR);
+
+    for (size_t i = 0; i < lines.size(); ++i) {
+        drawText(lines[i], 2 * margin, 2 * margin + i * lineHeight, scale);
+    }
+
+    flushText();
 }
 
 void Renderer::drawText(const std::string& text, float x, float y, float scale) {
-    // Text rendering is disabled (no GLUT)
-    // You can implement text rendering using another method if needed
+    static constexpr GLubyte TEXT_COLOR[4] = {230, 230, 230, 255};
+    const float cellU = static_cast<float>(font::GLYPH_WIDTH) / ATLAS_SIZE;
+    const float cellV = static_cast<float>(font::GLYPH_HEIGHT) / ATLAS_SIZE;
+    const float w = font::GLYPH_WIDTH * scale;
+    const float h = font::GLYPH_HEIGHT * scale;
+
+    float penX = x;
+    for (char c : text) {
+        if (c < font::FIRST_CHAR || c > font::LAST_CHAR) c = '?';
+        const int cell = c - font::FIRST_CHAR;
+        const float u = (cell % ATLAS_COLUMNS) * cellU;
+        const float v = (cell / ATLAS_COLUMNS) * cellV;
+
+        if (c != ' ') {
+            pushQuad(penX, y, penX + w, y + h, u, v, u + cellU, v + cellV, TEXT_COLOR);
+        }
+        penX += w;
+    }
+}
+
+void Renderer::drawPanel(float x, float y, float w, float h, const GLubyte color[4]) {
+    // Sample the centre of the solid atlas cell
+    const int cell = font::GLYPH_COUNT;
+    const float u = ((cell % ATLAS_COLUMNS) + 0.5f) * font::GLYPH_WIDTH / ATLAS_SIZE;
+    const float v = ((cell / ATLAS_COLUMNS) + 0.5f) * font::GLYPH_HEIGHT / ATLAS_SIZE;
+
+    pushQuad(x, y, x + w, y + h, u, v, u, v, color);
+}
+
+void Renderer::pushQuad(float x0, float y0, float x1, float y1,
+                        float u0, float v0, float u1, float v1, const GLubyte color[4]) {
+    const GLubyte r = color[0], g = color[1], b = color[2], a = color[3];
+    textBatch.push_back({x0, y0, u0, v0, {r, g, b, a}});
+    textBatch.push_back({x1, y0, u1, v0, {r, g, b, a}});
+    textBatch.push_back({x1, y1, u1, v1, {r, g, b, a}});
+    textBatch.push_back({x0, y1, u0, v1, {r, g, b, a}});
+}
+
+void Renderer::flushText() {
+    if (textBatch.empty()) return;
+
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, glyphTexture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), &textBatch[0].x);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), &textBatch[0].u);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex), textBatch[0].color);
+
+    // Whole overlay (panel and all glyphs) in a single draw call
+    glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(textBatch.size()));
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+
+    textBatch.clear();
 }
 
 void Renderer::framebufferSizeCallback(GLFWwindow* window, int width, int height) {
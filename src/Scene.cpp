@@ -0,0 +1,48 @@
+#include "Scene.h"
+#include "Config.h"
+#include <random>
+
+namespace sim {
+
+SimConstants makeConstants(float screenWidth, float screenHeight) {
+    SimConstants constants{};
+    constants.dt = config::Physics::DT;
+    constants.gravity = config::Physics::GRAVITY;
+    constants.restitution = config::Physics::RESTITUTION;
+    constants.screenDimensions = Vec2(screenWidth, screenHeight);
+    return constants;
+}
+
+std::vector<Ball> generateBalls(int numBalls, float screenWidth, float screenHeight, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> distX(0.0f, screenWidth);
+    std::uniform_real_distribution<float> distY(0.0f, screenHeight);
+    std::uniform_real_distribution<float> distVel(-config::Balls::VELOCITY_RANGE, config::Balls::VELOCITY_RANGE);
+    std::uniform_real_distribution<float> distRadius(config::Balls::MIN_RADIUS, config::Balls::MAX_RADIUS);
+    std::uniform_int_distribution<size_t> distColor(0, config::Balls::COLOR_COUNT - 1);
+
+    std::vector<Ball> balls(numBalls);
+    for (auto& ball : balls) {
+        ball.position = Vec2(distX(rng), distY(rng));
+        ball.velocity = Vec2(distVel(rng), distVel(rng));
+        ball.radius = distRadius(rng);
+        ball.mass = ball.radius * ball.radius; // Mass proportional to area
+        ball.color = config::Balls::COLORS[distColor(rng)];
+        ball.inverseMass = 1.0f / ball.mass;
+    }
+    return balls;
+}
+
+double totalEnergy(const std::vector<Ball>& balls, const SimConstants& constants) {
+    const double floorY = constants.screenDimensions.y;
+    double energy = 0.0;
+    for (const auto& ball : balls) {
+        const double vx = ball.velocity.x;
+        const double vy = ball.velocity.y;
+        energy += 0.5 * ball.mass * (vx * vx + vy * vy);
+        energy += ball.mass * constants.gravity * (floorY - ball.position.y);
+    }
+    return energy;
+}
+
+} // namespace sim
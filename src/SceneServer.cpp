@@ -0,0 +1,546 @@
+#include "SceneServer.h"
+#include "Affinity.h"
+#include "Config.h"
+#include "Log.h"
+#include "PhysicsBackend.h"
+#include "Scene.h"
+#include "SnapshotBuffer.h"
+#include "Trace.h"
+#include "Wire.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+namespace sim {
+
+struct SceneServer::Session {
+    uint32_t id{0};
+    // Backend, balls and constants belong to the scheduler: quanta and
+    // control jobs never run for one session at the same time
+    std::unique_ptr<PhysicsBackend> physics;
+    std::vector<Ball> balls;
+    SimConstants constants{};
+    float width{0.0f};
+    float height{0.0f};
+    bool shared{false};                  // steps on the shared worker pool
+
+    // Latest state for Snapshot and Status; the I/O thread is the consumer
+    SnapshotBuffer snapshots;
+    std::atomic<uint64_t> step{0};
+    std::atomic<uint64_t> requested{0};  // steps ever queued; requested - step are pending
+
+    uint64_t queued() const { return requested.load() - step.load(); }
+
+    std::string failed() const {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        return failure;
+    }
+    void fail(const std::string& reason) {
+        std::lock_guard<std::mutex> lock(failureMutex);
+        failure = reason;
+    }
+
+    ~Session() {
+        // Null when Create failed to build the backend
+        if (!physics) return;
+        try {
+            physics->cleanup();
+        } catch (const std::exception& error) {
+            SIM_LOG_WARN << "Session " << id << " cleanup failed: " << error.what();
+        }
+    }
+
+private:
+    mutable std::mutex failureMutex;
+    std::string failure;  // non-empty once the backend threw; guarded by failureMutex
+};
+
+namespace {
+
+using session::Request;
+using session::Status;
+
+std::string reply(Status status) {
+    wire::Writer out;
+    out.put(status);
+    return out.finish();
+}
+
+std::string reply(Status status, const std::string& message) {
+    wire::Writer out;
+    out.put(status).putString(message);
+    return out.finish();
+}
+
+} // namespace
+
+SceneServer::SceneServer(std::string socketPath_)
+    : socketPath(std::move(socketPath_))
+    , pool(std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+SceneServer::~SceneServer() {
+    stop();
+}
+
+void SceneServer::start() {
+    if (running.exchange(true)) return;
+    try {
+        listenFd = openListener();
+        if (pipe(wakeFds) < 0) {
+            throw std::runtime_error(std::string("Failed to create wake pipe: ") + std::strerror(errno));
+        }
+        fcntl(wakeFds[0], F_SETFL, O_NONBLOCK);
+        fcntl(wakeFds[1], F_SETFL, O_NONBLOCK);
+    } catch (...) {
+        running = false;
+        throw;
+    }
+    schedulerThread = std::thread(&SceneServer::scheduleLoop, this);
+    ioThread = std::thread(&SceneServer::serveLoop, this);
+}
+
+void SceneServer::stop() {
+    if (!running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+    }
+    workQueued.notify_all();
+    if (ioThread.joinable()) ioThread.join();
+    if (schedulerThread.joinable()) schedulerThread.join();
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+    }
+    unlink(socketPath.c_str());
+    for (int& fd : wakeFds) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        completed.clear();
+    }
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    controls.clear();
+    sessions.clear();
+}
+
+size_t SceneServer::sessionCount() const {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    return sessions.size();
+}
+
+int SceneServer::openListener() {
+    sockaddr_un addr{};
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Invalid server socket path: " + socketPath);
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str()); // stale socket from a previous run
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(fd, 16) < 0) {
+        const std::string reason = std::strerror(errno);
+        if (fd >= 0) close(fd);
+        throw std::runtime_error("Failed to listen on " + socketPath + ": " + reason);
+    }
+    return fd;
+}
+
+void SceneServer::serveLoop() {
+    SIM_TRACE_THREAD("server");
+
+    std::vector<Client> clients;
+    std::vector<pollfd> fds;
+    uint64_t nextClientId = 1;
+    std::vector<std::pair<uint64_t, std::string>> replies;
+
+    while (running) {
+        fds.assign({pollfd{listenFd, POLLIN, 0}, pollfd{wakeFds[0], POLLIN, 0}});
+        for (const Client& client : clients) {
+            // A client that is not reading its replies gets no more answers
+            short events = client.output.size() < config::Server::MAX_CLIENT_OUTPUT_BYTES ? POLLIN : 0;
+            if (!client.output.empty()) events |= POLLOUT;
+            fds.push_back(pollfd{client.fd, events, 0});
+        }
+        // Wake up periodically to notice stop()
+        if (poll(fds.data(), fds.size(), config::Server::POLL_INTERVAL_MS) <= 0) continue;
+
+        // Deferred replies from the scheduler; a client whose reply arrives
+        // goes on with the requests it sent meanwhile
+        if (fds[1].revents & POLLIN) {
+            char drained[64];
+            while (read(wakeFds[0], drained, sizeof(drained)) > 0) {}
+            {
+                std::lock_guard<std::mutex> lock(completedMutex);
+                replies.swap(completed);
+            }
+            for (auto& reply : replies) {
+                for (Client& client : clients) {
+                    if (client.id != reply.first || client.fd < 0) continue;
+                    client.output += reply.second;
+                    client.awaiting = false;
+                    if (!handleInput(client)) {
+                        close(client.fd);
+                        client.fd = -1;
+                    }
+                }
+            }
+            replies.clear();
+        }
+
+        // Clients beyond fds were accepted in this round and are polled next round
+        const size_t polled = fds.size() - 2;
+        for (size_t i = 0; i < polled; ++i) {
+            Client& client = clients[i];
+            if (client.fd < 0) continue;
+            const short revents = fds[i + 2].revents;
+            bool open = true;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) open = readClient(client);
+            if (open && !client.output.empty()) open = flushClient(client);
+            if (!open) {
+                close(client.fd);
+                client.fd = -1;
+            }
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [](const Client& client) { return client.fd < 0; }),
+                      clients.end());
+
+        if (fds[0].revents & POLLIN) {
+            const int fd = accept(listenFd, nullptr, nullptr);
+            if (fd >= 0) {
+                Client client;
+                client.id = nextClientId++;
+                client.fd = fd;
+                clients.push_back(std::move(client));
+            }
+        }
+    }
+
+    for (const Client& client : clients) close(client.fd);
+}
+
+// Reads what is available and answers every complete request; false once
+// the client is gone or broke the protocol
+bool SceneServer::readClient(Client& client) {
+    char buffer[4096];
+    const ssize_t n = recv(client.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    client.input.append(buffer, static_cast<size_t>(n));
+    return handleInput(client);
+}
+
+// Answers buffered requests until one is deferred or the output is full
+bool SceneServer::handleInput(Client& client) {
+    while (!client.awaiting && client.output.size() < config::Server::MAX_CLIENT_OUTPUT_BYTES) {
+        if (wire::frameLength(client.input) > config::Server::MAX_REQUEST_BYTES) {
+            SIM_LOG_WARN << "Dropping server client: oversized request";
+            return false;
+        }
+        const size_t frame = wire::completeFrame(client.input);
+        if (!frame) break;
+        client.output += handle(client, client.input.data() + wire::FRAME_HEADER_BYTES,
+                                frame - wire::FRAME_HEADER_BYTES);
+        client.input.erase(0, frame);
+    }
+    return client.input.size() <= config::Server::MAX_CLIENT_INPUT_BYTES;
+}
+
+bool SceneServer::flushClient(Client& client) {
+    const ssize_t n = send(client.fd, client.output.data(), client.output.size(),
+                           MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    client.output.erase(0, static_cast<size_t>(n));
+    // Room again for requests held back by a full output
+    return client.awaiting || handleInput(client);
+}
+
+std::shared_ptr<SceneServer::Session> SceneServer::find(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(sessionsMutex);
+    const auto it = sessions.find(id);
+    return it == sessions.end() ? nullptr : it->second;
+}
+
+void SceneServer::postControl(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        controls.push_back(std::move(job));
+    }
+    workQueued.notify_one();
+}
+
+void SceneServer::complete(uint64_t clientId, std::string reply) {
+    {
+        std::lock_guard<std::mutex> lock(completedMutex);
+        completed.emplace_back(clientId, std::move(reply));
+    }
+    const char wake = 1;
+    // A full pipe already has a wakeup pending
+    (void)!write(wakeFds[1], &wake, 1);
+}
+
+std::string SceneServer::handle(Client& client, const char* payload, size_t size) {
+    SIM_TRACE_SCOPE("serverRequest");
+    wire::Reader in(payload, size);
+
+    try {
+        const auto type = in.get<Request>();
+        if (type == Request::Create) {
+            std::string backendName = in.getString();
+            const uint32_t balls = in.get<uint32_t>();
+            const float width = in.get<float>();
+            const float height = in.get<float>();
+            const uint32_t seed = in.get<uint32_t>();
+            if (backendName.empty()) backendName = config::Server::DEFAULT_BACKEND;
+            if (balls > config::Server::MAX_SESSION_BALLS || !(width > 0.0f) || !(height > 0.0f)) {
+                return reply(Status::BadRequest, "ball count or screen size out of range");
+            }
+            if (sessionCount() >= config::Server::MAX_SESSIONS) {
+                return reply(Status::Busy, "session limit reached");
+            }
+
+            // Backend builds (an OpenCL program, say) run on the scheduler
+            const uint64_t clientId = client.id;
+            client.awaiting = true;
+            postControl([=] {
+                complete(clientId, createSession(backendName, balls, width, height, seed));
+            });
+            return {};
+        }
+
+        const uint32_t id = in.get<uint32_t>();
+        const auto target = find(id);
+        if (!target) return reply(Status::UnknownSession, "no session " + std::to_string(id));
+        Session& scene = *target;
+
+        switch (type) {
+        case Request::Step: {
+            const uint32_t steps = in.get<uint32_t>();
+            const std::string failure = scene.failed();
+            if (!failure.empty()) return reply(Status::BackendError, failure);
+            const uint64_t endsAt = scene.requested.fetch_add(steps) + steps;
+            // Pairs with the scheduler's wait, so the wakeup cannot be lost
+            {
+                std::lock_guard<std::mutex> lock(sessionsMutex);
+            }
+            workQueued.notify_one();
+            wire::Writer out;
+            out.put(Status::Ok).put(endsAt);
+            return out.finish();
+        }
+        case Request::Snapshot: {
+            const Snapshot& latest = scene.snapshots.acquire();
+            wire::Writer out;
+            out.put(Status::Ok).put(latest.step).put(static_cast<uint32_t>(latest.balls.size()));
+            for (const Ball& ball : latest.balls) {
+                const session::BallRecord record{ball.position.x, ball.position.y,
+                                                 ball.velocity.x, ball.velocity.y,
+                                                 ball.radius, ball.color};
+                out.putBytes(&record, sizeof(record));
+            }
+            return out.finish();
+        }
+        case Request::Spawn: {
+            const uint32_t count = in.get<uint32_t>();
+            const uint32_t seed = in.get<uint32_t>();
+            const uint64_t clientId = client.id;
+            client.awaiting = true;
+            postControl([this, clientId, target, count, seed] {
+                complete(clientId, spawn(*target, count, seed));
+            });
+            return {};
+        }
+        case Request::SetGravity: {
+            // Applied before the scheduler's next round, so before any
+            // step queued after this request
+            const float gravity = in.get<float>();
+            postControl([target, gravity] {
+                target->constants.gravity = gravity;
+                target->physics->setConstants(target->constants);
+            });
+            return reply(Status::Ok);
+        }
+        case Request::Status: {
+            const Snapshot& latest = scene.snapshots.acquire();
+            const uint64_t pending = scene.failed().empty() ? scene.queued() : 0;
+            wire::Writer out;
+            out.put(Status::Ok).put(scene.step.load()).put(pending)
+               .put(static_cast<uint32_t>(latest.balls.size()));
+            return out.finish();
+        }
+        case Request::Destroy: {
+            {
+                std::lock_guard<std::mutex> lock(sessionsMutex);
+                sessions.erase(id);
+            }
+            SIM_LOG_INFO << "Session " << id << " closed at step " << scene.step.load();
+            return reply(Status::Ok);
+        }
+        default:
+            return reply(Status::BadRequest, "unknown request type");
+        }
+    } catch (const std::out_of_range&) {
+        return reply(Status::BadRequest, "truncated request");
+    } catch (const std::exception& error) {
+        SIM_LOG_ERROR << "Server request failed: " << error.what();
+        return reply(Status::BackendError, error.what());
+    }
+}
+
+// Scheduler thread
+std::string SceneServer::createSession(const std::string& backendName, uint32_t balls,
+                                       float width, float height, uint32_t seed) {
+    auto created = std::make_shared<Session>();
+    try {
+        created->physics = createBackend(backendName);
+    } catch (const std::invalid_argument& error) {
+        return reply(Status::BadRequest, error.what());
+    }
+    try {
+        created->width = width;
+        created->height = height;
+        created->constants = makeConstants(width, height);
+        created->balls = generateBalls(static_cast<int>(balls), width, height, seed);
+        created->physics->initialize(created->balls.size(), static_cast<int>(width),
+                                     static_cast<int>(height));
+        created->physics->setConstants(created->constants);
+        created->shared = created->physics->name() == backend::CPU_SERIAL;
+        created->snapshots.publish(created->balls, 0);
+    } catch (const std::exception& error) {
+        SIM_LOG_ERROR << "Session on " << backendName << " failed to start: " << error.what();
+        return reply(Status::BackendError, error.what());
+    }
+
+    uint32_t id = 0;
+    {
+        std::lock_guard<std::mutex> lock(sessionsMutex);
+        // Other Creates may have been queued behind the same limit check
+        if (sessions.size() >= config::Server::MAX_SESSIONS) {
+            return reply(Status::Busy, "session limit reached");
+        }
+        id = nextSessionId++;
+        created->id = id;
+        sessions.emplace(id, created);
+    }
+    SIM_LOG_INFO << "Session " << id << ": " << balls << " balls on "
+                 << created->physics->name();
+    wire::Writer out;
+    out.put(Status::Ok).put(id);
+    return out.finish();
+}
+
+// Scheduler thread
+std::string SceneServer::spawn(Session& scene, uint32_t count, uint32_t seed) {
+    const std::string failure = scene.failed();
+    if (!failure.empty()) return reply(Status::BackendError, failure);
+    if (scene.balls.size() + count > config::Server::MAX_SESSION_BALLS) {
+        return reply(Status::BadRequest, "ball count out of range");
+    }
+    auto spawned = generateBalls(static_cast<int>(count), scene.width, scene.height, seed);
+    scene.balls.insert(scene.balls.end(), spawned.begin(), spawned.end());
+    // Device buffers are sized for the ball count. A backend that fails to
+    // come back up fails the session, like a failed step.
+    try {
+        scene.physics->cleanup();
+        scene.physics->initialize(scene.balls.size(), static_cast<int>(scene.width),
+                                  static_cast<int>(scene.height));
+        scene.physics->setConstants(scene.constants);
+    } catch (const std::exception& error) {
+        SIM_LOG_ERROR << "Session " << scene.id << " failed to respawn on "
+                      << scene.physics->name() << ": " << error.what();
+        scene.fail(error.what());
+        return reply(Status::BackendError, error.what());
+    }
+    scene.snapshots.publish(scene.balls, scene.step.load());
+    wire::Writer out;
+    out.put(Status::Ok).put(static_cast<uint32_t>(scene.balls.size()));
+    return out.finish();
+}
+
+void SceneServer::scheduleLoop() {
+    SIM_TRACE_THREAD("scheduler");
+    affinity::ThreadScope placement(affinity::Role::Physics);
+
+    std::vector<std::shared_ptr<Session>> shared;
+    std::vector<std::shared_ptr<Session>> exclusive;
+    std::deque<std::function<void()>> jobs;
+    auto collect = [&] {
+        shared.clear();
+        exclusive.clear();
+        for (const auto& entry : sessions) {
+            // A failed session keeps its queued steps but never runs them
+            if (entry.second->queued() == 0 || !entry.second->failed().empty()) continue;
+            (entry.second->shared ? shared : exclusive).push_back(entry.second);
+        }
+        return !shared.empty() || !exclusive.empty();
+    };
+
+    while (running) {
+        {
+            std::unique_lock<std::mutex> lock(sessionsMutex);
+            workQueued.wait_for(lock, std::chrono::milliseconds(config::Server::POLL_INTERVAL_MS),
+                                [&] {
+                                    const bool stepsQueued = collect();
+                                    return !running || stepsQueued || !controls.empty();
+                                });
+            jobs.swap(controls);
+        }
+        if (!running) break;
+
+        // Control jobs first, while no quantum runs
+        for (auto& job : jobs) {
+            try {
+                job();
+            } catch (const std::exception& error) {
+                SIM_LOG_ERROR << "Server control job failed: " << error.what();
+            }
+        }
+        jobs.clear();
+
+        // One round: every session with queued work gets one quantum. The
+        // single-threaded ones go out to the pool as one batch.
+        SIM_TRACE_SCOPE("serverRound");
+        pool.parallelFor(shared.size(), [&](size_t begin, size_t end, size_t /*worker*/) {
+            for (size_t i = begin; i < end; ++i) runQuantum(*shared[i]);
+        });
+        for (const auto& scene : exclusive) runQuantum(*scene);
+    }
+}
+
+void SceneServer::runQuantum(Session& scene) {
+    const uint64_t queued = scene.queued();
+    if (queued == 0) return;
+
+    const int steps = static_cast<int>(
+        std::min<uint64_t>(queued, static_cast<uint64_t>(config::Server::QUANTUM_STEPS)));
+    try {
+        if (steps == 1) {
+            scene.physics->updatePhysics(scene.balls);
+        } else {
+            scene.physics->advance(scene.balls, steps);
+        }
+        const uint64_t step = scene.step.load() + static_cast<uint64_t>(steps);
+        scene.snapshots.publish(scene.balls, step);
+        scene.step = step;
+    } catch (const std::exception& error) {
+        SIM_LOG_ERROR << "Session " << scene.id << " failed on " << scene.physics->name() << ": "
+                      << error.what();
+        scene.fail(error.what());
+    }
+}
+
+} // namespace sim
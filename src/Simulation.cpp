@@ -1,21 +1,48 @@
 #include "Simulation.h"
+#include "Scene.h"
+#include "Trace.h"
+#include "PerfCounters.h"
+#include "Log.h"
+#include "Affinity.h"
 #include <random>
-#include <iostream>
+#include <algorithm>
 #include <chrono>
+#include <future>
 
 namespace sim {
 
-Simulation::Simulation(int numBalls, float screenWidth_, float screenHeight_)
+Simulation::Simulation(int numBalls, float screenWidth_, float screenHeight_,
+                       const std::string& backendName)
     : renderer(screenWidth_, screenHeight_)
     , screenWidth(screenWidth_)
     , screenHeight(screenHeight_)
 {
-    std::cout << "Creating simulation with " << numBalls << " balls" << std::endl;
+    createdNs = trace::nowNs();
+    SIM_LOG_INFO << "Creating simulation with " << numBalls << " balls";
 
-    // Initialize renderer first
+    // Initialize simulation constants
+    constants = makeConstants(screenWidth, screenHeight);
+
+    // The physics backend (OpenCL context, program build, buffers, kernel
+    // prewarm) comes up on a helper thread while this thread creates the
+    // window and GL context, which GLFW requires on the main thread
+    auto backendReady = std::async(std::launch::async, [this, numBalls, backendName] {
+        const uint64_t startNs = trace::nowNs();
+        auto backend = createBackend(backendName);
+        backend->initialize(numBalls, static_cast<int>(screenWidth),
+                            static_cast<int>(screenHeight));
+        backend->setConstants(constants);
+        SIM_LOG_INFO << "Physics backend ready in " << (trace::nowNs() - startNs) / 1e6 << " ms";
+        return backend;
+    });
+
+    const uint64_t rendererStartNs = trace::nowNs();
     if (!renderer.initialize(numBalls)) {
+        // Let the backend finish before unwinding; its errors are secondary
+        try { backendReady.get(); } catch (...) {}
         throw std::runtime_error("Failed to initialize renderer");
     }
+    SIM_LOG_INFO << "Renderer ready in " << (trace::nowNs() - rendererStartNs) / 1e6 << " ms";
 
     // Store this pointer in window for callbacks
     glfwSetWindowUserPointer(renderer.getWindow(), this);
@@ -23,25 +50,21 @@ Simulation::Simulation(int numBalls, float screenWidth_, float screenHeight_)
     // Set up keyboard callback
     glfwSetKeyCallback(renderer.getWindow(), keyCallback);
 
-    // Initialize simulation constants
-    constants.dt = PHYSICS_DT;
-    constants.gravity = config::Physics::GRAVITY;
-    constants.restitution = config::Physics::RESTITUTION;
-    constants.screenDimensions = Vec2(screenWidth, screenHeight);
-
-    std::cout << "Initialized constants:" << std::endl
-              << "  dt: " << constants.dt << std::endl
-              << "  gravity: " << constants.gravity << std::endl
-              << "  restitution: " << constants.restitution << std::endl
-              << "  screen: " << screenWidth << "x" << screenHeight << std::endl;
-
-    // Initialize GPU manager
-    gpuManager.initialize(numBalls, static_cast<int>(screenWidth),
-                         static_cast<int>(screenHeight));
-    gpuManager.setConstants(constants);
+    SIM_LOG_INFO << "Initialized constants:";
+    SIM_LOG_INFO << "  dt: " << constants.dt;
+    SIM_LOG_INFO << "  gravity: " << constants.gravity;
+    SIM_LOG_INFO << "  restitution: " << constants.restitution;
+    SIM_LOG_INFO << "  screen: " << screenWidth << "x" << screenHeight;
+
+    // Rethrows anything the backend setup threw
+    physics = backendReady.get();
+    startupBackend = physics->name();
+    activeBackend = startupBackend;
 
     // Initialize balls
     initializeBalls(numBalls);
+
+    registerMetrics();
 }
 
 Simulation::~Simulation() {
@@ -49,39 +72,263 @@ Simulation::~Simulation() {
 }
 
 void Simulation::initializeBalls(int numBalls) {
-    std::mt19937 rng(std::random_device{}());
-    std::uniform_real_distribution<float> distX(0.0f, screenWidth);
-    std::uniform_real_distribution<float> distY(0.0f, screenHeight);
-    std::uniform_real_distribution<float> distVel(-config::Balls::VELOCITY_RANGE, config::Balls::VELOCITY_RANGE);
-    std::uniform_real_distribution<float> distRadius(config::Balls::MIN_RADIUS, config::Balls::MAX_RADIUS);
-    std::uniform_int_distribution<size_t> distColor(0, config::Balls::COLOR_COUNT - 1);
+    balls = generateBalls(numBalls, screenWidth, screenHeight, std::random_device{}());
+}
+
+void Simulation::registerMetrics() {
+    stepsMetric = &metricsRegistry.counter("physics_steps_total", "Physics steps completed");
+    framesMetric = &metricsRegistry.counter("frames_total", "Frames rendered");
+    contactsMetric = &metricsRegistry.counter("contacts_total", "Touching ball pairs summed over steps");
+    bytesMetric = &metricsRegistry.counter("transfer_bytes_total", "Host/device bytes transferred");
+    backendSwitchesMetric = &metricsRegistry.counter("backend_switches_total",
+                                                     "Physics backend changes at runtime");
+    failoversMetric = &metricsRegistry.counter("backend_failovers_total",
+                                               "Backend changes forced by a failed step");
+    migrationsMetric = &metricsRegistry.counter("partition_migrations_total",
+                                                "Balls moved between CPU spatial partitions");
+    fpsMetric = &metricsRegistry.gauge("fps", "Frames per second over the last second");
+    physicsRateMetric = &metricsRegistry.gauge("physics_rate", "Physics steps per second over the last second");
+    ballsMetric = &metricsRegistry.gauge("balls", "Number of simulated balls");
+    ballsMetric->set(static_cast<double>(balls.size()));
+    firstFrameMetric = &metricsRegistry.gauge("time_to_first_frame_seconds",
+                                              "From startup to the first rendered frame");
+
+    // Scheduler counters per thread role, sampled from the main thread
+    for (int role = 0; role < static_cast<int>(affinity::Role::COUNT); ++role) {
+        const std::string name = affinity::roleName(static_cast<affinity::Role>(role));
+        SchedMetrics& sched = schedMetrics[role];
+        sched.migrations = &metricsRegistry.counter(
+            name + "_thread_migrations_total", "CPU migrations of the " + name + " thread(s)");
+        sched.voluntarySwitches = &metricsRegistry.counter(
+            name + "_thread_voluntary_context_switches_total",
+            "Voluntary context switches of the " + name + " thread(s)");
+        sched.involuntarySwitches = &metricsRegistry.counter(
+            name + "_thread_involuntary_context_switches_total",
+            "Preemptions of the " + name + " thread(s)");
+    }
+
+    metricsRegistry.attachHistogram("physics_step_seconds", "Physics step wall time", stats.physicsStep);
+    metricsRegistry.attachHistogram("broadphase_seconds", "Broadphase time per step", stats.broadphase);
+    metricsRegistry.attachHistogram("narrowphase_seconds", "Narrowphase time per step", stats.narrowphase);
+    metricsRegistry.attachHistogram("frame_seconds", "Interval between frame starts", stats.frame);
+    metricsRegistry.attachHistogram("snapshot_age_seconds", "Snapshot age when drawn", stats.snapshotAge);
+}
 
-    balls.resize(numBalls);
-    for (auto& ball : balls) {
-        ball.position = Vec2(distX(rng), distY(rng));
-        ball.velocity = Vec2(distVel(rng), distVel(rng));
-        ball.radius = distRadius(rng);
-        ball.mass = ball.radius * ball.radius; // Mass proportional to area
-        ball.color = config::Balls::COLORS[distColor(rng)];
-        ball.padding = 0;
+void Simulation::sampleSchedMetrics() {
+    // Counters only move forward; a sample can lag behind the previous one
+    // when a thread's /proc entry disappears between reads
+    auto advance = [](MetricCounter* metric, uint64_t& last, uint64_t current) {
+        if (current > last) {
+            metric->add(current - last);
+            last = current;
+        }
+    };
+
+    for (int role = 0; role < static_cast<int>(affinity::Role::COUNT); ++role) {
+        SchedMetrics& sched = schedMetrics[role];
+        const auto current = affinity::sample(static_cast<affinity::Role>(role));
+        advance(sched.migrations, sched.last.migrations, current.migrations);
+        advance(sched.voluntarySwitches, sched.last.voluntarySwitches, current.voluntarySwitches);
+        advance(sched.involuntarySwitches, sched.last.involuntarySwitches, current.involuntarySwitches);
     }
 }
 
+void Simulation::post(Command command) {
+    commands.push(std::move(command));
+}
+
+void Simulation::pause() {
+    post([](Simulation& sim) { sim.paused = true; });
+}
+
+void Simulation::resume() {
+    post([](Simulation& sim) { sim.paused = false; });
+}
+
+void Simulation::togglePause() {
+    post([](Simulation& sim) { sim.paused = !sim.paused; });
+}
+
+void Simulation::reset() {
+    post([](Simulation& sim) {
+        sim.balls = generateBalls(static_cast<int>(sim.balls.size()), sim.screenWidth,
+                                  sim.screenHeight, sim.controlRng());
+        sim.rebuildBackend();
+    });
+}
+
+void Simulation::spawnBalls(int count) {
+    post([count](Simulation& sim) {
+        const int room = config::Balls::MAX_COUNT - static_cast<int>(sim.balls.size());
+        const int added = std::min(count, room);
+        if (added <= 0) return;
+
+        auto spawned = generateBalls(added, sim.screenWidth, sim.screenHeight, sim.controlRng());
+        sim.balls.insert(sim.balls.end(), spawned.begin(), spawned.end());
+        sim.rebuildBackend();
+    });
+}
+
+void Simulation::setGravity(float gravity) {
+    post([gravity](Simulation& sim) {
+        sim.constants.gravity = gravity;
+        sim.physics->setConstants(sim.constants);
+    });
+}
+
+void Simulation::adjustGravity(float delta) {
+    post([delta](Simulation& sim) {
+        sim.constants.gravity += delta;
+        sim.physics->setConstants(sim.constants);
+    });
+}
+
+void Simulation::switchBackend(const std::string& name) {
+    post([name](Simulation& sim) { sim.swapBackend(name, "requested"); });
+}
+
+void Simulation::toggleBackend() {
+    post([](Simulation& sim) {
+        const std::string failover = config::Physics::FAILOVER_BACKEND;
+        const std::string current = sim.physics->name();
+        if (current != failover) {
+            sim.swapBackend(failover, "requested");
+        } else {
+            const bool startedElsewhere = sim.startupBackend != failover;
+            sim.swapBackend(startedElsewhere ? sim.startupBackend : backend::OPENCL, "requested");
+        }
+    });
+}
+
+std::string Simulation::backendName() const {
+    std::lock_guard<std::mutex> lock(backendNameMutex);
+    return activeBackend;
+}
+
+bool Simulation::swapBackend(const std::string& name, const char* reason) {
+    // The ball vector is the live state: every backend takes it on its
+    // first step, so migrating is initializing the new one from it
+    std::unique_ptr<PhysicsBackend> next;
+    try {
+        next = createBackend(name);
+        next->initialize(balls.size(), static_cast<int>(screenWidth),
+                         static_cast<int>(screenHeight));
+        next->setConstants(constants);
+    } catch (const std::exception& error) {
+        SIM_LOG_ERROR << "Cannot switch to " << name << " backend: " << error.what();
+        return false;
+    }
+
+    const std::string previous = physics->name();
+    if (backendSteps) {
+        SIM_LOG_INFO << previous << ": " << backendSteps << " steps, mean "
+                     << backendStepNs / 1e6 / backendSteps << " ms/step";
+    }
+    physics->cleanup();
+    physics = std::move(next);
+    backendSteps = 0;
+    backendStepNs = 0;
+    {
+        std::lock_guard<std::mutex> lock(backendNameMutex);
+        activeBackend = physics->name();
+    }
+    backendSwitchesMetric->add();
+    SIM_LOG_INFO << "Switched physics backend " << previous << " -> " << physics->name()
+                 << " (" << reason << ") at step " << stepCount;
+    return true;
+}
+
+bool Simulation::stepOrFailover() {
+    try {
+        physics->updatePhysics(balls);
+        return true;
+    } catch (const std::exception& error) {
+        SIM_LOG_ERROR << "Physics step failed on " << physics->name() << ": " << error.what();
+    }
+
+    // Device errors leave the ball vector at the last good step; redo the
+    // step on the failover backend
+    if (physics->name() == config::Physics::FAILOVER_BACKEND ||
+        !swapBackend(config::Physics::FAILOVER_BACKEND, "failover")) {
+        return false;
+    }
+    failoversMetric->add();
+    try {
+        physics->updatePhysics(balls);
+        return true;
+    } catch (const std::exception& error) {
+        SIM_LOG_ERROR << "Physics step failed on " << physics->name() << ": " << error.what();
+        return false;
+    }
+}
+
+void Simulation::recordBackendStep(uint64_t stepNs) {
+    ++backendSteps;
+    backendStepNs += stepNs;
+}
+
+void Simulation::drainCommands() {
+    Command command;
+    bool changed = false;
+    while (commands.pop(command)) {
+        command(*this);
+        changed = true;
+    }
+
+    // Let the renderer see the new state even while paused
+    if (changed) {
+        snapshots.publish(balls, stepCount);
+    }
+}
+
+void Simulation::rebuildBackend() {
+    // Device buffers are sized for the ball count and host-side backends
+    // keep their own partitioned copy of the state
+    try {
+        physics->cleanup();
+        physics->initialize(balls.size(), static_cast<int>(screenWidth),
+                            static_cast<int>(screenHeight));
+        physics->setConstants(constants);
+        SIM_LOG_INFO << "Physics backend reloaded with " << balls.size() << " balls";
+    } catch (const std::exception& error) {
+        // The ball vector is intact; a fresh failover backend starts from it
+        SIM_LOG_ERROR << "Reloading " << physics->name() << " failed: " << error.what();
+        if (!swapBackend(config::Physics::FAILOVER_BACKEND, "failover")) {
+            stopOnPhysicsFailure();
+            return;
+        }
+        failoversMetric->add();
+    }
+    ballsMetric->set(static_cast<double>(balls.size()));
+}
+
+void Simulation::stopOnPhysicsFailure() {
+    // Nothing left to step the scene with: shut down instead of letting the
+    // exception escape the physics thread
+    SIM_LOG_ERROR << "No physics backend can continue; closing";
+    running = false;
+    glfwSetWindowShouldClose(renderer.getWindow(), GLFW_TRUE);
+}
+
 void Simulation::start() {
     if (!running.exchange(true)) {
+        snapshots.publish(balls, stepCount);
         physicsThread = std::thread(&Simulation::physicsLoop, this);
         renderThread = std::thread(&Simulation::renderLoop, this);
     }
 }
 
 void Simulation::stop() {
-    if (running.exchange(false)) {
-        if (physicsThread.joinable()) physicsThread.join();
-        if (renderThread.joinable()) renderThread.join();
-    }
+    // The physics thread clears running itself when no backend can step
+    running = false;
+    if (physicsThread.joinable()) physicsThread.join();
+    if (renderThread.joinable()) renderThread.join();
 }
 
 void Simulation::physicsLoop() {
+    SIM_TRACE_THREAD("physics");
+    affinity::ThreadScope placement(affinity::Role::Physics);
+
     using clock = std::chrono::steady_clock;
     auto nextUpdate = clock::now();
     const auto updateInterval = std::chrono::duration_cast<clock::duration>(
@@ -89,8 +336,35 @@ void Simulation::physicsLoop() {
     );
 
     while (running && !shouldClose()) {
+        drainCommands();
+        if (!running) break;
+
         if (!paused) {
-            gpuManager.updatePhysics(balls);
+            SIM_TRACE_SCOPE("physicsStep");
+            const uint64_t stepStart = trace::nowNs();
+            if (!stepOrFailover()) {
+                stopOnPhysicsFailure();
+                break;
+            }
+            const uint64_t stepNs = trace::nowNs() - stepStart;
+            recordBackendStep(stepNs);
+            stats.physicsStep.record(stepNs);
+            recentSteps.record(stepNs);
+
+            const StepStats stepStats = physics->lastStepStats();
+            if (stepStats.broadphaseNs) stats.broadphase.record(stepStats.broadphaseNs);
+            if (stepStats.narrowphaseNs) stats.narrowphase.record(stepStats.narrowphaseNs);
+            lastContacts.store(stepStats.contacts, std::memory_order_relaxed);
+            bytesTransferred.fetch_add(stepStats.bytesTransferred, std::memory_order_relaxed);
+            stepsMetric->add();
+            contactsMetric->add(stepStats.contacts);
+            bytesMetric->add(stepStats.bytesTransferred);
+            migrationsMetric->add(stepStats.migrations);
+
+            {
+                perf::PhaseScope counters(perf::Phase::Publish);
+                snapshots.publish(balls, ++stepCount);
+            }
         }
 
         nextUpdate += updateInterval;
@@ -99,6 +373,9 @@ void Simulation::physicsLoop() {
 }
 
 void Simulation::renderLoop() {
+    SIM_TRACE_THREAD("render");
+    affinity::ThreadScope placement(affinity::Role::Render);
+
     // Make the OpenGL context current in this thread
     glfwMakeContextCurrent(renderer.getWindow());
 
@@ -122,26 +399,77 @@ void Simulation::renderLoop() {
     int frameCount = 0;
     double fpsTimer = 0.0;
     double currentFPS = 0.0;
+    bool firstFrame = true;
+    bool firstFrameShown = false;
+
+    // Overlay numbers are refreshed together with the FPS counter
+    OverlayStats overlay;
+    overlay.ballCount = snapshots.acquire().balls.size();
+    overlay.backendName = backendName();
+    uint64_t lastOverlayStep = 0;
+    uint64_t lastOverlayBytes = 0;
 
-    std::cout << "Render loop starting" << std::endl;
+    SIM_LOG_INFO << "Render loop starting";
 
     while (running && !shouldClose()) {
         auto currentTime = clock::now();
         double deltaTime = std::chrono::duration<double>(currentTime - lastTime).count();
         lastTime = currentTime;
 
+        // Interval between consecutive frame starts
+        if (!firstFrame) {
+            stats.frame.record(static_cast<uint64_t>(deltaTime * 1e9));
+        }
+        firstFrame = false;
+
         // Update FPS counter
         frameCount++;
         fpsTimer += deltaTime;
         if (fpsTimer >= 1.0) {
             currentFPS = frameCount / fpsTimer;
+
+            // The ball vector belongs to the physics thread; read the snapshot
+            const Snapshot& latest = snapshots.acquire();
+            const uint64_t step = latest.step;
+            const uint64_t bytes = bytesTransferred.load(std::memory_order_relaxed);
+            overlay.fps = currentFPS;
+            overlay.ballCount = latest.balls.size();
+            overlay.backendName = backendName();
+            overlay.physicsRate = (step - lastOverlayStep) / fpsTimer;
+            overlay.stepP50Ms = recentSteps.percentile(0.50) / 1e6;
+            overlay.stepP99Ms = recentSteps.percentile(0.99) / 1e6;
+            overlay.stepP999Ms = recentSteps.percentile(0.999) / 1e6;
+            overlay.contactsPerStep = lastContacts.load(std::memory_order_relaxed);
+            overlay.transferMBps = (bytes - lastOverlayBytes) / fpsTimer / 1e6;
+            fpsMetric->set(overlay.fps);
+            physicsRateMetric->set(overlay.physicsRate);
+            recentSteps.reset();
+            lastOverlayStep = step;
+            lastOverlayBytes = bytes;
+
             frameCount = 0;
             fpsTimer = 0.0;
         }
 
-        // Render current state
-        if (!paused) {
-            renderer.render(balls, currentFPS);
+        // Render current state; while paused this redraws the last snapshot
+        // and keeps polling input so the pause can be lifted again
+        {
+            SIM_TRACE_SCOPE("frame");
+            const Snapshot& snapshot = snapshots.acquire();
+            stats.snapshotAge.record(trace::nowNs() - snapshot.publishNs);
+            renderer.render(snapshot.balls, overlayVisible ? &overlay : nullptr);
+            framesMetric->add();
+        }
+        if (!firstFrameShown) {
+            firstFrameShown = true;
+            const double seconds = (trace::nowNs() - createdNs) / 1e9;
+            firstFrameMetric->set(seconds);
+            SIM_LOG_INFO << "Time to first frame: " << seconds * 1e3 << " ms";
+        }
+
+        // Flag frames that blew the display budget
+        if (deltaTime > config::Display::FRAME_TIME * 1.05) {
+            SIM_TRACE_INSTANT("missedFrameBudget");
         }
 
         // Wait for next frame
@@ -163,12 +491,39 @@ void Simulation::keyCallback(GLFWwindow* window, int key, int /*scancode*/, int
     auto* sim = static_cast<Simulation*>(glfwGetWindowUserPointer(window));
     if (!sim) return;
 
-    if (key == GLFW_KEY_P && action == GLFW_PRESS) {
-        if (sim->isPaused()) {
-            sim->resume();
-        } else {
-            sim->pause();
-        }
+    if (action != GLFW_PRESS) return;
+
+    switch (key) {
+        case GLFW_KEY_P:
+            sim->togglePause();
+            break;
+        case GLFW_KEY_R:
+            sim->reset();
+            break;
+        case GLFW_KEY_SPACE:
+            sim->spawnBalls(config::Balls::SPAWN_COUNT);
+            break;
+        case GLFW_KEY_UP:
+            sim->adjustGravity(config::Physics::GRAVITY_STEP);
+            break;
+        case GLFW_KEY_DOWN:
+            sim->adjustGravity(-config::Physics::GRAVITY_STEP);
+            break;
+        case GLFW_KEY_B:
+            sim->toggleBackend();
+            break;
+        case GLFW_KEY_G:
+            sim->post([](Simulation& s) {
+                s.constants.gravity = s.constants.gravity != 0.0f ? 0.0f : config::Physics::GRAVITY;
+                s.physics->setConstants(s.constants);
+            });
+            break;
+        default:
+            break;
+    }
+
+    if (key == GLFW_KEY_F1) {
+        sim->overlayVisible = !sim->overlayVisible;
     }
 }
 
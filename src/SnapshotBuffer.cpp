@@ -0,0 +1,22 @@
+#include "SnapshotBuffer.h"
+#include "Trace.h"
+
+namespace sim {
+
+void SnapshotBuffer::publish(const std::vector<Ball>& balls, uint64_t step) {
+    Snapshot& slot = slots[back];
+    slot.balls.assign(balls.begin(), balls.end());
+    slot.step = step;
+    slot.publishNs = trace::nowNs();
+
+    back = middle.exchange(back | DIRTY, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+const Snapshot& SnapshotBuffer::acquire() {
+    if (middle.load(std::memory_order_relaxed) & DIRTY) {
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    return slots[front];
+}
+
+} // namespace sim
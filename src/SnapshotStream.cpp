@@ -0,0 +1,333 @@
+#include "SnapshotStream.h"
+#include "Config.h"
+#include "Log.h"
+#include "Trace.h"
+#include "Wire.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace sim {
+
+namespace {
+
+sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un addr{};
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Invalid stream socket path: " + path);
+    }
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    return addr;
+}
+
+int32_t quantize(float position) {
+    return static_cast<int32_t>(std::lrint(position / config::Stream::POSITION_QUANTUM));
+}
+
+} // namespace
+
+SnapshotStream::SnapshotStream(std::string socketPath_)
+    : socketPath(std::move(socketPath_))
+{
+}
+
+SnapshotStream::~SnapshotStream() {
+    stop();
+}
+
+void SnapshotStream::start() {
+    if (running.exchange(true)) return;
+    try {
+        listenFd = openListener();
+    } catch (...) {
+        running = false;
+        throw;
+    }
+    thread = std::thread(&SnapshotStream::serveLoop, this);
+}
+
+void SnapshotStream::stop() {
+    if (!running.exchange(false)) return;
+    if (thread.joinable()) thread.join();
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+    }
+    unlink(socketPath.c_str());
+}
+
+void SnapshotStream::publish(const std::vector<Ball>& balls, uint64_t step) {
+    snapshots.publish(balls, step);
+}
+
+int SnapshotStream::openListener() {
+    const sockaddr_un addr = socketAddress(socketPath);
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str()); // stale socket from a previous run
+    if (fd < 0 || bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(fd, 8) < 0) {
+        const std::string reason = std::strerror(errno);
+        if (fd >= 0) close(fd);
+        throw std::runtime_error("Failed to listen on " + socketPath + ": " + reason);
+    }
+    return fd;
+}
+
+void SnapshotStream::serveLoop() {
+    SIM_TRACE_THREAD("stream");
+
+    std::vector<Viewer> viewers;
+    std::vector<pollfd> fds;
+
+    while (running) {
+        // Sleep until the next viewer is due, or until socket activity
+        const uint64_t now = trace::nowNs();
+        int timeoutMs = config::Stream::POLL_INTERVAL_MS;
+        fds.assign(1, pollfd{listenFd, POLLIN, 0});
+        for (const Viewer& viewer : viewers) {
+            const short events = viewer.output.empty() ? POLLIN : (POLLIN | POLLOUT);
+            fds.push_back(pollfd{viewer.fd, events, 0});
+            if (viewer.intervalNs) {
+                const uint64_t wait = viewer.nextSendNs > now ? viewer.nextSendNs - now : 0;
+                timeoutMs = std::min(timeoutMs, static_cast<int>((wait + 999999) / 1000000));
+            }
+        }
+        poll(fds.data(), fds.size(), timeoutMs);
+
+        // Viewers beyond fds were accepted in this round and are polled next round
+        const size_t polled = fds.size() - 1;
+        for (size_t i = 0; i < polled; ++i) {
+            Viewer& viewer = viewers[i];
+            const short revents = fds[i + 1].revents;
+            bool open = true;
+            if (revents & (POLLIN | POLLHUP | POLLERR)) open = readViewer(viewer);
+            if (open && !viewer.output.empty()) open = flushViewer(viewer);
+            if (!open) closeViewer(viewer);
+        }
+
+        const Snapshot& latest = snapshots.acquire();
+        const uint64_t sendNs = trace::nowNs();
+        for (Viewer& viewer : viewers) {
+            if (viewer.fd < 0 || !viewer.intervalNs || sendNs < viewer.nextSendNs) continue;
+            if (latest.balls.empty() || (viewer.keyed && latest.step == viewer.lastStep)) {
+                // Nothing new yet; publications are not signalled, so look again shortly
+                viewer.nextSendNs = sendNs + std::min<uint64_t>(viewer.intervalNs, 1000000);
+                continue;
+            }
+
+            viewer.nextSendNs = std::max(viewer.nextSendNs + viewer.intervalNs, sendNs);
+            if (!viewer.output.empty()) {
+                // Still sending the previous frame
+                ++viewer.dropped;
+                continue;
+            }
+            SIM_TRACE_SCOPE("streamFrame");
+            encode(viewer, latest);
+            if (!flushViewer(viewer)) closeViewer(viewer);
+        }
+
+        viewers.erase(std::remove_if(viewers.begin(), viewers.end(),
+                                     [](const Viewer& viewer) { return viewer.fd < 0; }),
+                      viewers.end());
+
+        if (fds[0].revents & POLLIN) {
+            const int fd = accept(listenFd, nullptr, nullptr);
+            if (fd >= 0) {
+                Viewer viewer;
+                viewer.fd = fd;
+                viewers.push_back(std::move(viewer));
+            }
+        }
+    }
+
+    for (Viewer& viewer : viewers) closeViewer(viewer);
+}
+
+bool SnapshotStream::readViewer(Viewer& viewer) {
+    char buffer[256];
+    const ssize_t n = recv(viewer.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    viewer.input.append(buffer, static_cast<size_t>(n));
+
+    while (const size_t frame = wire::completeFrame(viewer.input)) {
+        try {
+            wire::Reader in(viewer.input.data() + wire::FRAME_HEADER_BYTES,
+                            frame - wire::FRAME_HEADER_BYTES);
+            if (in.get<stream::Message>() != stream::Message::Hello) return false;
+            const double requested = in.get<float>();
+            // A NaN would slip through the clamp; infinity clamps to MAX_FPS
+            const double fps = std::isnan(requested)
+                ? config::Stream::DEFAULT_FPS
+                : std::min(std::max(requested, 1.0), config::Stream::MAX_FPS);
+            viewer.intervalNs = static_cast<uint64_t>(1e9 / fps);
+            viewer.nextSendNs = trace::nowNs();
+            SIM_LOG_INFO << "Viewer connected at " << fps << " fps";
+        } catch (const std::out_of_range&) {
+            return false;
+        }
+        viewer.input.erase(0, frame);
+    }
+    // Viewers only ever send a hello
+    return viewer.input.size() < 64;
+}
+
+bool SnapshotStream::flushViewer(Viewer& viewer) {
+    const ssize_t n = send(viewer.fd, viewer.output.data(), viewer.output.size(),
+                           MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    viewer.output.erase(0, static_cast<size_t>(n));
+    return true;
+}
+
+void SnapshotStream::encode(Viewer& viewer, const Snapshot& snapshot) {
+    const size_t count = snapshot.balls.size();
+    std::vector<int32_t> x(count), y(count);
+    for (size_t i = 0; i < count; ++i) {
+        x[i] = quantize(snapshot.balls[i].position.x);
+        y[i] = quantize(snapshot.balls[i].position.y);
+    }
+
+    bool key = !viewer.keyed || count != viewer.baseX.size() ||
+               viewer.framesSinceKey >= config::Stream::KEYFRAME_INTERVAL;
+    wire::Writer out;
+    if (!key) {
+        out.put(stream::Message::Delta).put(snapshot.step).put(static_cast<uint32_t>(count));
+        constexpr int32_t LIMIT = std::numeric_limits<int16_t>::max();
+        for (size_t i = 0; i < count; ++i) {
+            const int32_t dx = x[i] - viewer.baseX[i];
+            const int32_t dy = y[i] - viewer.baseY[i];
+            if (dx < -LIMIT || dx > LIMIT || dy < -LIMIT || dy > LIMIT) {
+                key = true; // a jump, e.g. after a reset
+                break;
+            }
+            out.put(static_cast<int16_t>(dx)).put(static_cast<int16_t>(dy));
+        }
+    }
+    if (key) {
+        out = wire::Writer();
+        out.put(stream::Message::Keyframe).put(snapshot.step).put(static_cast<uint32_t>(count));
+        for (size_t i = 0; i < count; ++i) {
+            out.put(x[i]).put(y[i]).put(snapshot.balls[i].radius).put(snapshot.balls[i].color);
+        }
+        viewer.keyed = true;
+        viewer.framesSinceKey = 0;
+        ++viewer.keyframes;
+    } else {
+        ++viewer.framesSinceKey;
+    }
+
+    const std::string& frame = out.finish();
+    viewer.output += frame;
+    viewer.bytes += frame.size();
+    ++viewer.frames;
+    viewer.lastStep = snapshot.step;
+    viewer.baseX.swap(x);
+    viewer.baseY.swap(y);
+}
+
+void SnapshotStream::closeViewer(Viewer& viewer) {
+    if (viewer.fd < 0) return;
+    close(viewer.fd);
+    viewer.fd = -1;
+    SIM_LOG_INFO << "Viewer disconnected: " << viewer.frames << " frames (" << viewer.keyframes
+                 << " keyframes), " << viewer.dropped << " dropped, " << viewer.bytes / 1024
+                 << " KiB";
+}
+
+StreamClient::StreamClient(std::string socketPath_)
+    : socketPath(std::move(socketPath_))
+{
+}
+
+StreamClient::~StreamClient() {
+    if (fd >= 0) close(fd);
+}
+
+void StreamClient::connect(double fps) {
+    const sockaddr_un addr = socketAddress(socketPath);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+        throw std::runtime_error("Failed to connect to " + socketPath + ": " + std::strerror(errno));
+    }
+
+    wire::Writer hello;
+    hello.put(stream::Message::Hello).put(static_cast<float>(fps));
+    const std::string& frame = hello.finish();
+    if (send(fd, frame.data(), frame.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(frame.size())) {
+        throw std::runtime_error("Failed to send hello to " + socketPath);
+    }
+}
+
+bool StreamClient::poll(int timeoutMs) {
+    pollfd pfd{fd, POLLIN, 0};
+    if (::poll(&pfd, 1, timeoutMs) <= 0) return false;
+
+    char buffer[64 * 1024];
+    while (true) {
+        const ssize_t n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (n == 0) throw std::runtime_error("Stream closed");
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Stream read failed: ") + std::strerror(errno));
+        }
+        input.append(buffer, static_cast<size_t>(n));
+        received += static_cast<uint64_t>(n);
+    }
+
+    bool changed = false;
+    while (const size_t frame = wire::completeFrame(input)) {
+        apply(input.data() + wire::FRAME_HEADER_BYTES, frame - wire::FRAME_HEADER_BYTES);
+        input.erase(0, frame);
+        changed = true;
+    }
+    return changed;
+}
+
+void StreamClient::apply(const char* payload, size_t size) {
+    const float quantum = config::Stream::POSITION_QUANTUM;
+    wire::Reader in(payload, size);
+    const auto type = in.get<stream::Message>();
+    const uint64_t step = in.get<uint64_t>();
+    const size_t count = in.get<uint32_t>();
+
+    if (type == stream::Message::Keyframe) {
+        state.assign(count, Ball{});
+        positionX.resize(count);
+        positionY.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            positionX[i] = in.get<int32_t>();
+            positionY[i] = in.get<int32_t>();
+            Ball& ball = state[i];
+            ball.position = Vec2(positionX[i] * quantum, positionY[i] * quantum);
+            ball.radius = in.get<float>();
+            ball.color = in.get<uint32_t>();
+            ball.mass = ball.radius * ball.radius;
+            ball.inverseMass = 1.0f / ball.mass;
+        }
+        keyed = true;
+    } else if (type == stream::Message::Delta) {
+        if (!keyed || count != state.size()) {
+            throw std::runtime_error("Stream delta does not match the last keyframe");
+        }
+        for (size_t i = 0; i < count; ++i) {
+            positionX[i] += in.get<int16_t>();
+            positionY[i] += in.get<int16_t>();
+            state[i].position = Vec2(positionX[i] * quantum, positionY[i] * quantum);
+        }
+    } else {
+        throw std::runtime_error("Unexpected stream message");
+    }
+    lastStep = step;
+}
+
+} // namespace sim
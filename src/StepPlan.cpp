@@ -0,0 +1,150 @@
+#include "StepPlan.h"
+#include "Config.h"
+#include "Log.h"
+#include <string>
+#include <type_traits>
+
+namespace sim {
+
+// Entry points of the provisional extension, looked up per platform.
+// Headers that predate it leave the plan on the replay path.
+#if defined(cl_khr_command_buffer)
+struct StepPlan::Extension {
+    clCreateCommandBufferKHR_fn create{nullptr};
+    clCommandNDRangeKernelKHR_fn ndRange{nullptr};
+    clFinalizeCommandBufferKHR_fn finalize{nullptr};
+    clEnqueueCommandBufferKHR_fn enqueue{nullptr};
+    clReleaseCommandBufferKHR_fn release{nullptr};
+};
+#else
+struct StepPlan::Extension {};
+#endif
+
+StepPlan::StepPlan() = default;
+
+StepPlan::~StepPlan() {
+    reset();
+}
+
+void StepPlan::reset() {
+#if defined(cl_khr_command_buffer)
+    if (commandBuffer) {
+        extension->release(static_cast<cl_command_buffer_khr>(commandBuffer));
+    }
+#endif
+    commandBuffer = nullptr;
+    extension.reset();
+    integrateKernel = cl::Kernel();
+    collideKernel = cl::Kernel();
+    ready = false;
+}
+
+void StepPlan::build(const cl::Device& device, const cl::CommandQueue& queue,
+                     const cl::Kernel& integrate, const cl::Kernel& collide,
+                     size_t globalSize, size_t localSize) {
+    reset();
+    integrateKernel = integrate;
+    collideKernel = collide;
+    global = cl::NDRange(globalSize);
+    local = cl::NDRange(localSize);
+    ready = true;
+
+    if (record(device, queue, globalSize, localSize)) {
+        SIM_LOG_INFO << "Step plan recorded into a command buffer";
+    } else {
+        SIM_LOG_INFO << "Step plan replays bound kernels";
+    }
+}
+
+bool StepPlan::record(const cl::Device& device, const cl::CommandQueue& queue,
+                      size_t globalSize, size_t localSize) {
+#if defined(cl_khr_command_buffer)
+    if (!config::OpenCL::COMMAND_BUFFERS) return false;
+    if (device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_command_buffer") == std::string::npos) {
+        return false;
+    }
+
+    const cl_platform_id platform = device.getInfo<CL_DEVICE_PLATFORM>();
+    auto lookup = [&](auto& entry, const char* name) {
+        entry = reinterpret_cast<std::remove_reference_t<decltype(entry)>>(
+            clGetExtensionFunctionAddressForPlatform(platform, name));
+        return entry != nullptr;
+    };
+    auto ext = std::make_unique<Extension>();
+    if (!lookup(ext->create, "clCreateCommandBufferKHR") ||
+        !lookup(ext->ndRange, "clCommandNDRangeKernelKHR") ||
+        !lookup(ext->finalize, "clFinalizeCommandBufferKHR") ||
+        !lookup(ext->enqueue, "clEnqueueCommandBufferKHR") ||
+        !lookup(ext->release, "clReleaseCommandBufferKHR")) {
+        SIM_LOG_WARN << "cl_khr_command_buffer advertised but entry points missing";
+        return false;
+    }
+
+    cl_int error = CL_SUCCESS;
+    cl_command_queue target = queue();
+    cl_command_buffer_khr buffer = ext->create(1, &target, nullptr, &error);
+    if (error != CL_SUCCESS) {
+        SIM_LOG_WARN << "clCreateCommandBufferKHR failed (" << error << ")";
+        return false;
+    }
+
+    // Arguments are captured now, so the kernels must be bound already
+    cl_sync_point_khr integrated = 0;
+    error = ext->ndRange(buffer, nullptr, nullptr, integrateKernel(), 1, nullptr,
+                         &globalSize, &localSize, 0, nullptr, &integrated, nullptr);
+    if (error == CL_SUCCESS) {
+        error = ext->ndRange(buffer, nullptr, nullptr, collideKernel(), 1, nullptr,
+                             &globalSize, &localSize, 1, &integrated, nullptr, nullptr);
+    }
+    if (error == CL_SUCCESS) {
+        error = ext->finalize(buffer);
+    }
+    if (error != CL_SUCCESS) {
+        SIM_LOG_WARN << "Recording the step plan failed (" << error << ")";
+        ext->release(buffer);
+        return false;
+    }
+
+    commandBuffer = buffer;
+    extension = std::move(ext);
+    return true;
+#else
+    (void)device;
+    (void)queue;
+    (void)globalSize;
+    (void)localSize;
+    return false;
+#endif
+}
+
+void StepPlan::enqueue(const cl::CommandQueue& queue, const std::vector<cl::Event>& integrateDeps,
+                       const std::vector<cl::Event>& collideDeps, cl::Event& integrated,
+                       cl::Event& collided) const {
+#if defined(cl_khr_command_buffer)
+    if (commandBuffer) {
+        std::vector<cl_event> waits;
+        waits.reserve(integrateDeps.size() + collideDeps.size());
+        for (const auto& event : integrateDeps) waits.push_back(event());
+        for (const auto& event : collideDeps) waits.push_back(event());
+
+        cl_event event = nullptr;
+        const cl_int error = extension->enqueue(
+            0, nullptr, static_cast<cl_command_buffer_khr>(commandBuffer),
+            static_cast<cl_uint>(waits.size()), waits.empty() ? nullptr : waits.data(), &event);
+        if (error != CL_SUCCESS) {
+            throw cl::Error(error, "clEnqueueCommandBufferKHR");
+        }
+        integrated = cl::Event(event);
+        collided = integrated;
+        return;
+    }
+#endif
+
+    queue.enqueueNDRangeKernel(integrateKernel, cl::NullRange, global, local,
+                               &integrateDeps, &integrated);
+    std::vector<cl::Event> waits = collideDeps;
+    waits.push_back(integrated);
+    queue.enqueueNDRangeKernel(collideKernel, cl::NullRange, global, local, &waits, &collided);
+}
+
+} // namespace sim
@@ -0,0 +1,170 @@
+#include "Trace.h"
+#include "Config.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sim {
+namespace trace {
+
+namespace {
+
+struct Event {
+    const char* name;
+    const char* track; // nullptr: the owning thread's track
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+// Single-writer buffer owned by one thread. Slots below `count` are never
+// modified again, so the dumper can read them without synchronizing with
+// the writer beyond the acquire load of `count`.
+struct ThreadBuffer {
+    explicit ThreadBuffer(uint32_t tid_)
+        : tid(tid_), events(new Event[config::Trace::EVENTS_PER_THREAD]) {}
+
+    void push(const Event& event) {
+        const size_t n = count.load(std::memory_order_relaxed);
+        if (n >= config::Trace::EVENTS_PER_THREAD) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events[n] = event;
+        count.store(n + 1, std::memory_order_release);
+    }
+
+    const uint32_t tid;
+    std::string name; // guarded by Registry::mutex
+    std::unique_ptr<Event[]> events;
+    std::atomic<size_t> count{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    uint32_t nextTid{1};
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+ThreadBuffer& localBuffer() {
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        auto created = std::make_shared<ThreadBuffer>(reg.nextTid++);
+        created->name = "thread " + std::to_string(created->tid);
+        reg.buffers.push_back(created);
+        return created;
+    }();
+    return *buffer;
+}
+
+void writeEscaped(std::ostream& out, const char* text) {
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        out << *c;
+    }
+}
+
+} // namespace
+
+uint64_t nowNs() {
+    using clock = std::chrono::steady_clock;
+    static const clock::time_point epoch = clock::now();
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - epoch).count());
+}
+
+void setThreadName(const char* name) {
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.name = name;
+}
+
+void recordSpan(const char* name, uint64_t startNs, uint64_t endNs) {
+    localBuffer().push({name, nullptr, startNs, endNs});
+}
+
+void recordTrackSpan(const char* track, const char* name, uint64_t startNs, uint64_t endNs) {
+    localBuffer().push({name, track, startNs, endNs});
+}
+
+void recordInstant(const char* name) {
+    const uint64_t now = nowNs();
+    localBuffer().push({name, nullptr, now, now});
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    // Synthetic tracks get ids after the real threads
+    std::map<std::string, uint32_t> trackIds;
+    auto trackId = [&](const char* track) {
+        auto it = trackIds.find(track);
+        if (it == trackIds.end()) {
+            it = trackIds.emplace(track, reg.nextTid + static_cast<uint32_t>(trackIds.size())).first;
+        }
+        return it->second;
+    };
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&] {
+        if (!first) out << ",\n";
+        first = false;
+    };
+
+    for (const auto& buffer : reg.buffers) {
+        const size_t n = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < n; ++i) {
+            const Event& e = buffer->events[i];
+            const uint32_t tid = e.track ? trackId(e.track) : buffer->tid;
+            separator();
+            out << "{\"name\":\"";
+            writeEscaped(out, e.name);
+            if (e.endNs == e.startNs && !e.track) {
+                out << "\",\"ph\":\"i\",\"s\":\"t\",\"ts\":" << e.startNs / 1000.0;
+            } else {
+                out << "\",\"ph\":\"X\",\"ts\":" << e.startNs / 1000.0
+                    << ",\"dur\":" << (e.endNs - e.startNs) / 1000.0;
+            }
+            out << ",\"pid\":1,\"tid\":" << tid << "}";
+        }
+
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":\"";
+        writeEscaped(out, buffer->name.c_str());
+        out << "\",\"dropped\":" << buffer->dropped.load(std::memory_order_relaxed) << "}}";
+    }
+
+    for (const auto& [track, tid] : trackIds) {
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"";
+        writeEscaped(out, track.c_str());
+        out << "\"}}";
+    }
+
+    out << "\n]}\n";
+    return out.good();
+}
+
+} // namespace trace
+} // namespace sim
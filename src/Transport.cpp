@@ -0,0 +1,123 @@
+#include "Transport.h"
+#include "Wire.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace sim {
+
+LocalSocketTransport::LocalSocketTransport(int rank, std::vector<int> fds)
+    : self(rank)
+    , peerFds(std::move(fds))
+    , backlog(peerFds.size())
+{
+}
+
+LocalSocketTransport::~LocalSocketTransport() {
+    for (int fd : peerFds) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+std::vector<std::vector<int>> LocalSocketTransport::createMesh(int ranks) {
+    std::vector<std::vector<int>> mesh(ranks, std::vector<int>(ranks, -1));
+    for (int a = 0; a < ranks; ++a) {
+        for (int b = a + 1; b < ranks; ++b) {
+            int pair[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) < 0) {
+                throw std::runtime_error(std::string("socketpair failed: ") + std::strerror(errno));
+            }
+            mesh[a][b] = pair[0];
+            mesh[b][a] = pair[1];
+        }
+    }
+    return mesh;
+}
+
+std::vector<std::string> LocalSocketTransport::exchange(const std::vector<int>& peers,
+                                                        const std::vector<std::string>& outgoing) {
+    const size_t count = peers.size();
+    std::vector<std::string> frames(count);
+    std::vector<size_t> sent(count, 0);
+    std::vector<std::string> received(count);
+    std::vector<bool> complete(count, false);
+    size_t pending = 2 * count;
+    for (size_t i = 0; i < count; ++i) {
+        wire::Writer frame;
+        frame.putBytes(outgoing[i].data(), outgoing[i].size());
+        frames[i] = std::move(frame.finish());
+
+        // A peer that finished the previous exchange first may already
+        // have sent its next message
+        received[i] = std::move(backlog.at(peers[i]));
+        backlog[peers[i]].clear();
+        if (wire::completeFrame(received[i])) {
+            complete[i] = true;
+            --pending;
+        }
+    }
+
+    // Send and receive interleaved, so two ranks sending each other more
+    // than a socket buffer at once both make progress
+    std::vector<pollfd> fds(count);
+    while (pending > 0) {
+        for (size_t i = 0; i < count; ++i) {
+            short events = 0;
+            if (sent[i] < frames[i].size()) events |= POLLOUT;
+            if (!complete[i]) events |= POLLIN;
+            fds[i] = pollfd{events ? peerFds.at(peers[i]) : -1, events, 0};
+        }
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Transport poll failed: ") + std::strerror(errno));
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            const int fd = fds[i].fd;
+            if (fd < 0) continue;
+            if (fds[i].revents & POLLOUT) {
+                const ssize_t n = send(fd, frames[i].data() + sent[i], frames[i].size() - sent[i],
+                                       MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    throw std::runtime_error("Send to rank " + std::to_string(peers[i]) +
+                                             " failed: " + std::strerror(errno));
+                }
+                if (n > 0) {
+                    sent[i] += static_cast<size_t>(n);
+                    if (sent[i] == frames[i].size()) --pending;
+                }
+            }
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                char buffer[64 * 1024];
+                const ssize_t n = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+                if (n == 0) {
+                    throw std::runtime_error("Rank " + std::to_string(peers[i]) + " disconnected");
+                }
+                if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    throw std::runtime_error("Receive from rank " + std::to_string(peers[i]) +
+                                             " failed: " + std::strerror(errno));
+                }
+                if (n > 0) {
+                    received[i].append(buffer, static_cast<size_t>(n));
+                    if (wire::completeFrame(received[i])) {
+                        complete[i] = true;
+                        --pending;
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const size_t frame = wire::completeFrame(received[i]);
+        backlog[peers[i]] = received[i].substr(frame);
+        received[i].resize(frame);
+        received[i].erase(0, wire::FRAME_HEADER_BYTES);
+    }
+    return received;
+}
+
+} // namespace sim
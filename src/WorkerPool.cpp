@@ -0,0 +1,86 @@
+#include "WorkerPool.h"
+#include "Trace.h"
+#include "Affinity.h"
+#include <algorithm>
+#include <string>
+
+namespace sim {
+
+WorkerPool::WorkerPool(size_t numThreads)
+    : numWorkers(std::max<size_t>(numThreads, 1))
+{
+    if (numWorkers == 1) return;  // inline
+    threads.reserve(numWorkers);
+    for (size_t i = 0; i < numWorkers; ++i) {
+        threads.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    startCv.notify_all();
+    for (auto& thread : threads) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, const RangeFn& fn) {
+    if (count == 0) return;
+    if (threads.empty()) {
+        fn(0, count, 0);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    job = &fn;
+    jobCount = count;
+    pending = numWorkers;
+    ++generation;
+    startCv.notify_all();
+
+    doneCv.wait(lock, [this] { return pending == 0; });
+    job = nullptr;
+}
+
+void WorkerPool::workerLoop(size_t worker) {
+    if (trace::ENABLED) {
+        trace::setThreadName(("worker " + std::to_string(worker)).c_str());
+    }
+    affinity::ThreadScope placement(affinity::Role::Worker, worker);
+
+    size_t seenGeneration = 0;
+
+    while (true) {
+        const RangeFn* fn = nullptr;
+        size_t count = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCv.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+            fn = job;
+            count = jobCount;
+        }
+
+        // Static contiguous partition
+        const size_t workers = numWorkers;
+        const size_t chunk = (count + workers - 1) / workers;
+        const size_t begin = std::min(count, worker * chunk);
+        const size_t end = std::min(count, begin + chunk);
+        if (begin < end) {
+            (*fn)(begin, end, worker);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending == 0) {
+                doneCv.notify_one();
+            }
+        }
+    }
+}
+
+} // namespace sim
@@ -1,11 +1,16 @@
+// Hot per-step state, 16 bytes
 typedef struct {
     float2 position;
     float2 velocity;
+} BallState;
+
+// Cold per-ball constants
+typedef struct {
     float radius;
+    float inverseMass;
     float mass;
     uint color;
-    uint padding;
-} Ball;
+} BallProperties;
 
 typedef struct {
     float dt;
@@ -16,15 +21,8 @@ typedef struct {
     float2 reserved;
 } SimConstants;
 
-__kernel void updateBallPhysics(
-    __global Ball* balls,
-    __constant SimConstants* constants,
-    const int numBalls
-) {
-    int i = get_global_id(0);
-    if (i >= numBalls) return;
-
-    Ball ball = balls[i];
+// Integration and boundary response of one ball
+BallState integrateBall(BallState ball, float radius, __constant SimConstants* constants) {
     float dt = constants->dt;
     float gravity = constants->gravity;
     float2 screenDim = constants->screenDimensions;
@@ -38,51 +36,60 @@ __kernel void updateBallPhysics(
     float restitution = constants->restitution;
 
     // Horizontal boundaries
-    if (ball.position.x - ball.radius < 0.0f) {
-        ball.position.x = ball.radius;
+    if (ball.position.x - radius < 0.0f) {
+        ball.position.x = radius;
         ball.velocity.x = fabs(ball.velocity.x) * restitution;
     }
-    else if (ball.position.x + ball.radius > screenDim.x) {
-        ball.position.x = screenDim.x - ball.radius;
+    else if (ball.position.x + radius > screenDim.x) {
+        ball.position.x = screenDim.x - radius;
         ball.velocity.x = -fabs(ball.velocity.x) * restitution;
     }
 
     // Vertical boundaries
-    if (ball.position.y - ball.radius < 0.0f) {
-        ball.position.y = ball.radius;
+    if (ball.position.y - radius < 0.0f) {
+        ball.position.y = radius;
         ball.velocity.y = fabs(ball.velocity.y) * restitution;
     }
-    else if (ball.position.y + ball.radius > screenDim.y) {
-        ball.position.y = screenDim.y - ball.radius;
+    else if (ball.position.y + radius > screenDim.y) {
+        ball.position.y = screenDim.y - radius;
         ball.velocity.y = -fabs(ball.velocity.y) * restitution;
     }
 
-    balls[i] = ball;
+    return ball;
 }
 
-__kernel void detectCollisions(
-    __global Ball* balls,
-    __constant SimConstants* constants,
-    const int numBalls
+// Ball-ball response of ball `gid` against every other ball. Touching
+// pairs are added to contactCount when it is not null.
+BallState collideBall(
+    __global const BallState* states,
+    __global const BallProperties* properties,
+    int gid,
+    int numBalls,
+    float restitution,
+    __global uint* contactCount
 ) {
-    int gid = get_global_id(0);
-    if (gid >= numBalls) return;
-
-    Ball myBall = balls[gid];
-    float restitution = constants->restitution;
+    BallState myBall = states[gid];
+    BallProperties myProps = properties[gid];
 
     // Check collisions with other balls
     for (int j = 0; j < numBalls; j++) {
         if (j == gid) continue;
 
-        Ball otherBall = balls[j];
+        BallState otherBall = states[j];
         float2 diff = otherBall.position - myBall.position;
         float distSq = dot(diff, diff);
-        float minDist = myBall.radius + otherBall.radius;
+        float minDist = myProps.radius + properties[j].radius;
 
         if (distSq < minDist * minDist && distSq > 0.0f) {
+            // Each touching pair is counted once, by its lower index
+            if (contactCount && gid < j) atomic_inc(contactCount);
+
+#ifdef SIM_FAST_MATH
+            float2 normal = diff * native_rsqrt(distSq);
+#else
             float dist = sqrt(distSq);
             float2 normal = diff / dist;
+#endif
 
             // Calculate relative velocity
             float2 relativeVel = otherBall.velocity - myBall.velocity;
@@ -90,15 +97,80 @@ __kernel void detectCollisions(
 
             // Only resolve if balls are moving toward each other
             if (velAlongNormal < 0) {
-                float j = -(1.0f + restitution) * velAlongNormal;
-                j /= 1.0f/myBall.mass + 1.0f/otherBall.mass;
-
-                float2 impulse = j * normal;
-                myBall.velocity -= impulse / myBall.mass;
+                float scale = -(1.0f + restitution) * velAlongNormal;
+#ifdef SIM_FAST_MATH
+                scale = native_divide(scale, myProps.inverseMass + properties[j].inverseMass);
+#else
+                scale /= myProps.inverseMass + properties[j].inverseMass;
+#endif
+
+                float2 impulse = scale * normal;
+                myBall.velocity -= impulse * myProps.inverseMass;
             }
         }
     }
 
-    balls[gid] = myBall;
+    return myBall;
+}
+
+__kernel void updateBallPhysics(
+    __global BallState* states,
+    __global const BallProperties* properties,
+    __constant SimConstants* constants,
+    const int numBalls
+) {
+    int i = get_global_id(0);
+    if (i >= numBalls) return;
+
+    states[i] = integrateBall(states[i], properties[i].radius, constants);
+}
+
+__kernel void detectCollisions(
+    __global BallState* states,
+    __global const BallProperties* properties,
+    __constant SimConstants* constants,
+    const int numBalls,
+    __global uint* contactCount
+) {
+    int gid = get_global_id(0);
+    if (gid >= numBalls) return;
+
+    states[gid] = collideBall(states, properties, gid, numBalls, constants->restitution, contactCount);
 }
 
+// Persistent variant for small scenes: a single work-group advances `steps`
+// steps in one launch. Work-group barriers separate the phases, so no
+// cross-group synchronization is needed; collision results go to `next`
+// until every ball has read the integrated state. Contacts are counted for
+// the last step only.
+__kernel void simulateSteps(
+    __global BallState* states,
+    __global const BallProperties* properties,
+    __constant SimConstants* constants,
+    const int numBalls,
+    const int steps,
+    __global BallState* next,
+    __global uint* contactCount
+) {
+    int lid = get_local_id(0);
+    int size = get_local_size(0);
+    float restitution = constants->restitution;
+
+    for (int step = 0; step < steps; step++) {
+        for (int i = lid; i < numBalls; i += size) {
+            states[i] = integrateBall(states[i], properties[i].radius, constants);
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
+
+        __global uint* counter = step == steps - 1 ? contactCount : 0;
+        for (int i = lid; i < numBalls; i += size) {
+            next[i] = collideBall(states, properties, i, numBalls, restitution, counter);
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
+
+        for (int i = lid; i < numBalls; i += size) {
+            states[i] = next[i];
+        }
+        barrier(CLK_GLOBAL_MEM_FENCE);
+    }
+}
@@ -1,7 +1,23 @@
 #include "Simulation.h"
+#include "DiffHarness.h"
+#include "Benchmark.h"
+#include "MetricsServer.h"
+#include "SceneServer.h"
+#include "SnapshotStream.h"
+#include "AsyncScene.h"
+#include "Distributed.h"
+#include "Log.h"
+#include "Affinity.h"
+#include "Memory.h"
+#include "CPUPhysics.h"
+#include "Trace.h"
 #include <iostream>
 #include <stdexcept>
 #include <csignal>
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <sstream>
 
 namespace {
     volatile std::sig_atomic_t g_running = 1;
@@ -16,39 +32,363 @@ void setupSignalHandling() {
     std::signal(SIGTERM, signalHandler);
 }
 
+void printUsage(const char* program) {
+    std::cout << "Usage:\n"
+              << "  " << program << " [numBalls] [--backend opencl|opencl-fast|opencl-persistent|cpu|cpu-serial|cpu-soa|cpu-aosoa8|cpu-aosoa16]\n"
+              << "  " << program << " [numBalls] --diff <reference> <candidate>"
+              << " [--steps N] [--seed S] [--deterministic]\n"
+              << "  " << program << " [numBalls] --bench <backend>"
+              << " [--steps N] [--seed S] [--perf-counters] [--batch N] [--prefetch-sweep] [--output file.json]\n"
+              << "  " << program << " [numBalls] --bench-layouts"
+              << " [--steps N] [--seed S] [--perf-counters] [--output file.json]\n"
+              << "  " << program << " --serve <socket>  host scenes for clients (e.g. "
+              << sim::config::Server::DEFAULT_SOCKET << ")\n"
+              << "  " << program << " [numBalls] --stream <socket> [--backend B] [--steps N] [--seed S]"
+              << "  headless run for viewers (e.g. " << sim::config::Stream::DEFAULT_SOCKET << ")\n"
+              << "  " << program << " --view <socket> [--view-fps N]  watch a --stream run\n"
+              << "  " << program << " [numBalls] --distributed <ranks> [--steps N] [--seed S] [--no-verify]"
+              << "  slab-decomposed run across processes\n";
+    std::cout << "  --pin-physics|--pin-render|--pin-workers <cpus>  pin threads to a cpulist"
+              << " (e.g. 0-3,8) or NUMA node (node1)\n"
+              << "  --rt-priority <1-99>  run the physics thread SCHED_FIFO\n"
+              << "  --huge-pages off|thp|explicit  back large physics arrays with 2 MB pages\n"
+              << "  --prefetch <balls>  CPU narrowphase prefetch distance, 0 disables (default "
+              << sim::config::Grid::PREFETCH_DISTANCE << ")\n";
+    std::cout << "  --metrics <unix:/path|port>  serve Prometheus metrics (e.g. "
+              << sim::config::Metrics::DEFAULT_ENDPOINT << ")\n";
+    if (sim::trace::ENABLED) {
+        std::cout << "  --trace <file>  write a Chrome trace-event timeline on exit (default "
+                  << sim::config::Trace::DEFAULT_FILENAME << ")\n";
+    }
+}
+
+void writeTrace(const std::string& path) {
+    if (!sim::trace::ENABLED) return;
+    if (sim::trace::writeChromeTrace(path)) {
+        SIM_LOG_INFO << "Trace written to " << path;
+    } else {
+        SIM_LOG_ERROR << "Failed to write trace to " << path;
+    }
+}
+
+void logLatency(const sim::LatencyStats& stats) {
+    std::ostringstream table;
+    stats.print(table);
+    std::istringstream lines(table.str());
+    for (std::string line; std::getline(lines, line);) {
+        SIM_LOG_INFO << line;
+    }
+}
+
+int runDiff(const sim::DiffOptions& options) {
+    sim::DifferentialHarness harness(options);
+    sim::DiffReport report = harness.run();
+    report.print(std::cout);
+    return report.passed() ? 0 : 2;
+}
+
+// Headless run paced like the interactive physics thread, streamed to viewers
+int runStream(const std::string& socketPath, const std::string& backendName, int numBalls,
+              uint32_t seed, int steps) {
+    const int batch = sim::config::Stream::PUBLISH_EVERY_STEPS;
+    sim::AsyncScene scene(backendName, numBalls, sim::config::Display::DEFAULT_WIDTH,
+                          sim::config::Display::DEFAULT_HEIGHT, seed);
+    sim::SnapshotStream stream(socketPath);
+    stream.start();
+    SIM_LOG_INFO << "Streaming " << numBalls << " balls on " << scene.backendName() << " to "
+                 << socketPath;
+
+    using clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(sim::config::Physics::DT * batch));
+    auto nextPublish = clock::now();
+    uint64_t done = 0;
+    while (g_running && (steps <= 0 || done < static_cast<uint64_t>(steps))) {
+        done = scene.stepAsync(batch).get();
+        stream.publish(scene.latest().balls, done);
+        nextPublish += interval;
+        std::this_thread::sleep_until(nextPublish);
+    }
+    stream.stop();
+    return 0;
+}
+
+int runViewer(const std::string& socketPath, double fps) {
+    sim::StreamClient client(socketPath);
+    client.connect(fps);
+
+    sim::Renderer renderer(sim::config::Display::DEFAULT_WIDTH, sim::config::Display::DEFAULT_HEIGHT);
+    renderer.initialize(0);
+    glfwMakeContextCurrent(renderer.getWindow());
+    renderer.setupOpenGL();
+
+    sim::OverlayStats overlay;
+    overlay.backendName = "stream " + socketPath;
+    using clock = std::chrono::steady_clock;
+    auto lastSample = clock::now();
+    uint64_t lastStep = 0;
+    uint64_t lastBytes = 0;
+    int frames = 0;
+    const auto frameInterval = std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(sim::config::Display::FRAME_TIME));
+    auto nextFrame = clock::now();
+
+    while (g_running && !renderer.shouldClose()) {
+        // Take frames as they arrive until the next redraw is due
+        nextFrame += frameInterval;
+        try {
+            int64_t wait = 0;
+            do {
+                client.poll(static_cast<int>(wait));
+                wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    nextFrame - clock::now()).count();
+            } while (wait > 0);
+        } catch (const std::exception& error) {
+            SIM_LOG_INFO << error.what();
+            break;
+        }
+        renderer.render(client.balls(), &overlay);
+        ++frames;
+
+        const double elapsed = std::chrono::duration<double>(clock::now() - lastSample).count();
+        if (elapsed >= 1.0) {
+            overlay.fps = frames / elapsed;
+            overlay.physicsRate = (client.step() - lastStep) / elapsed;
+            overlay.ballCount = client.balls().size();
+            overlay.transferMBps = (client.bytesReceived() - lastBytes) / elapsed / 1e6;
+            lastSample = clock::now();
+            lastStep = client.step();
+            lastBytes = client.bytesReceived();
+            frames = 0;
+        }
+    }
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
+    sim::log::Session logSession;
+
     try {
         setupSignalHandling();
 
-        int numBalls = sim::config::Balls::DEFAULT_COUNT;
-        if (argc > 1) {
-            numBalls = std::stoi(argv[1]);
-            numBalls = std::clamp(numBalls, sim::config::Balls::MIN_COUNT, sim::config::Balls::MAX_COUNT);
+        int numBalls = 0;  // 0: the mode's default
+        int steps = 0;
+        std::string backendName = sim::backend::OPENCL;
+        bool diffMode = false;
+        bool benchMode = false;
+        bool layoutBenchMode = false;
+        sim::DiffOptions diffOptions;
+        sim::BenchmarkOptions benchOptions;
+        std::string tracePath = sim::config::Trace::DEFAULT_FILENAME;
+        std::string metricsEndpoint;
+        std::string serverSocket;
+        std::string streamSocket;
+        std::string viewSocket;
+        double viewFps = sim::config::Stream::DEFAULT_FPS;
+        int distributedRanks = 0;
+        bool distributedVerify = true;
+        int rank = -1;  // set only in a spawned rank
+        std::string rankFds;
+        sim::affinity::Placement placement;
+
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto next = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+
+            if (arg == "--backend") {
+                backendName = next();
+            } else if (arg == "--diff") {
+                diffMode = true;
+                diffOptions.referenceBackend = next();
+                diffOptions.candidateBackend = next();
+            } else if (arg == "--bench") {
+                benchMode = true;
+                benchOptions.backendName = next();
+            } else if (arg == "--bench-layouts") {
+                layoutBenchMode = true;
+            } else if (arg == "--steps") {
+                steps = std::stoi(next());
+            } else if (arg == "--seed") {
+                diffOptions.seed = static_cast<uint32_t>(std::stoul(next()));
+                benchOptions.seed = diffOptions.seed;
+            } else if (arg == "--perf-counters") {
+                benchOptions.perfCounters = true;
+            } else if (arg == "--batch") {
+                benchOptions.batchSteps = std::stoi(next());
+            } else if (arg == "--prefetch-sweep") {
+                benchOptions.prefetchSweep.assign(std::begin(sim::config::Grid::PREFETCH_SWEEP),
+                                                  std::end(sim::config::Grid::PREFETCH_SWEEP));
+            } else if (arg == "--output") {
+                benchOptions.outputPath = next();
+            } else if (arg == "--serve") {
+                serverSocket = next();
+            } else if (arg == "--stream") {
+                streamSocket = next();
+            } else if (arg == "--view") {
+                viewSocket = next();
+            } else if (arg == "--view-fps") {
+                viewFps = std::stod(next());
+            } else if (arg == "--distributed") {
+                distributedRanks = std::stoi(next());
+            } else if (arg == "--no-verify") {
+                distributedVerify = false;
+            } else if (arg == "--rank") {
+                rank = std::stoi(next());
+            } else if (arg == "--rank-fds") {
+                rankFds = next();
+            } else if (arg == "--metrics") {
+                metricsEndpoint = next();
+            } else if (arg == "--pin-physics") {
+                placement.physicsCpus = next();
+            } else if (arg == "--pin-render") {
+                placement.renderCpus = next();
+            } else if (arg == "--pin-workers") {
+                placement.workerCpus = next();
+            } else if (arg == "--rt-priority") {
+                placement.physicsPriority = std::stoi(next());
+            } else if (arg == "--huge-pages") {
+                sim::memory::setHugePages(sim::memory::parseHugePages(next()));
+            } else if (arg == "--prefetch") {
+                sim::grid::setPrefetchDistance(std::stoul(next()));
+            } else if (arg == "--trace") {
+                tracePath = next();
+            } else if (arg == "--deterministic") {
+                diffOptions.deterministic = true;
+            } else if (arg == "--help" || arg == "-h") {
+                printUsage(argv[0]);
+                return 0;
+            } else {
+                numBalls = std::max(std::stoi(arg), sim::config::Balls::MIN_COUNT);
+            }
+        }
+
+        // Before any backend spins up its worker pool
+        sim::affinity::configure(placement);
+
+        if (diffMode) {
+            if (numBalls) diffOptions.numBalls = numBalls;
+            if (steps) diffOptions.steps = steps;
+            const int status = runDiff(diffOptions);
+            writeTrace(tracePath);
+            return status;
         }
 
+        if (layoutBenchMode) {
+            if (numBalls) benchOptions.numBalls = numBalls;
+            benchOptions.steps = steps ? steps : sim::config::Benchmark::LAYOUT_ITERATIONS;
+            return sim::LayoutBenchmark(benchOptions).run() ? 0 : 1;
+        }
+
+        if (!serverSocket.empty()) {
+            sim::SceneServer server(serverSocket);
+            server.start();
+            SIM_LOG_INFO << "Serving scenes on " << serverSocket;
+            while (g_running) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            server.stop();
+            writeTrace(tracePath);
+            return 0;
+        }
+
+        if (!streamSocket.empty()) {
+            if (numBalls) diffOptions.numBalls = numBalls;
+            return runStream(streamSocket, backendName, diffOptions.numBalls, diffOptions.seed, steps);
+        }
+
+        if (!viewSocket.empty()) {
+            return runViewer(viewSocket, viewFps);
+        }
+
+        if (distributedRanks) {
+            sim::DistributedOptions options;
+            options.ranks = distributedRanks;
+            if (numBalls) options.numBalls = numBalls;
+            if (steps) options.steps = steps;
+            options.seed = diffOptions.seed;
+            options.verify = distributedVerify;
+            // Spawned ranks would all write the same trace file
+            if (rank > 0) return sim::runRank(options, rank, rankFds);
+            const int status = sim::launchDistributed(options, argc, argv);
+            writeTrace(tracePath);
+            return status;
+        }
+
+        if (benchMode) {
+            if (numBalls) benchOptions.numBalls = numBalls;
+            if (steps) benchOptions.steps = steps;
+            const bool written = sim::Benchmark(benchOptions).run();
+            writeTrace(tracePath);
+            return written ? 0 : 1;
+        }
+
+        // The interactive view is limited to what the renderer handles well
+        numBalls = numBalls ? std::min(numBalls, sim::config::Balls::MAX_COUNT)
+                            : sim::config::Balls::DEFAULT_COUNT;
+
         sim::Simulation simulation(
             numBalls,
             sim::config::Display::DEFAULT_WIDTH,
-            sim::config::Display::DEFAULT_HEIGHT
+            sim::config::Display::DEFAULT_HEIGHT,
+            backendName
         );
 
         std::cout << "\nBouncing Balls Simulation\n"
                   << "Controls:\n"
-                  << "  ESC - Exit\n"
-                  << "  P   - Pause/Resume\n\n";
+                  << "  ESC   - Exit\n"
+                  << "  P     - Pause/Resume\n"
+                  << "  R     - Reset scene\n"
+                  << "  Space - Spawn balls\n"
+                  << "  Up/Dn - Adjust gravity\n"
+                  << "  G     - Toggle gravity\n"
+                  << "  B     - Switch between OpenCL and CPU physics\n"
+                  << "  F1    - Performance overlay\n\n";
+
+        // Declared after the simulation so it stops before the registry goes away
+        std::unique_ptr<sim::MetricsServer> metricsServer;
+        if (!metricsEndpoint.empty()) {
+            metricsServer = std::make_unique<sim::MetricsServer>(simulation.metrics(), metricsEndpoint);
+            metricsServer->start();
+            SIM_LOG_INFO << "Serving metrics on " << metricsEndpoint;
+        }
 
         simulation.start();
 
+        using clock = std::chrono::steady_clock;
+        const auto reportInterval = std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(sim::config::Stats::REPORT_INTERVAL_SECONDS)
+        );
+        auto nextReport = clock::now() + reportInterval;
+        const auto schedInterval = std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>(sim::config::Stats::SCHED_SAMPLE_INTERVAL_SECONDS)
+        );
+        auto nextSchedSample = clock::now() + schedInterval;
+
         while (g_running && !simulation.shouldClose()) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            // /proc reads stay off the render and physics threads
+            if (clock::now() >= nextSchedSample) {
+                simulation.sampleSchedMetrics();
+                nextSchedSample += schedInterval;
+            }
+
+            if (clock::now() >= nextReport) {
+                logLatency(simulation.latencyStats());
+                nextReport += reportInterval;
+            }
         }
 
         simulation.stop();
+        logLatency(simulation.latencyStats());
+        writeTrace(tracePath);
         return 0;
     }
     catch (const std::exception& e) {
-        std::cerr << "Error: " << e.what() << std::endl;
+        SIM_LOG_ERROR << "Error: " << e.what();
         return 1;
     }
 }
-